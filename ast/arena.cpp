@@ -0,0 +1,58 @@
+#include "arena.h"
+
+#include <algorithm>
+#include <cstring>
+
+void* Arena::allocate(size_t size, size_t alignment) {
+    auto address = reinterpret_cast<uintptr_t>(cursor);
+    auto aligned = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+    if (!cursor || aligned + size > reinterpret_cast<uintptr_t>(limit)) {
+        addChunk(size + alignment);
+        address = reinterpret_cast<uintptr_t>(cursor);
+        aligned = (address + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+    }
+
+    cursor = reinterpret_cast<char*>(aligned + size);
+    allocations++;
+    bytesUsed += size;
+    return reinterpret_cast<void*>(aligned);
+}
+
+// Chunks double up to maxChunkSize, so a large AST needs few of them; an oversized request gets a chunk of its own.
+void Arena::addChunk(size_t minimum) {
+    size_t size = std::max(nextChunkSize, minimum);
+    nextChunkSize = std::min(nextChunkSize * 2, maxChunkSize);
+    chunks.emplace_back(new char[size]);
+    cursor = chunks.back().get();
+    limit = cursor + size;
+}
+
+std::string_view Arena::copyString(std::string_view text) {
+    if (text.empty()) return {};
+    auto copy = static_cast<char*>(allocate(text.length(), 1));
+    std::memcpy(copy, text.data(), text.length());
+    return {copy, text.length()};
+}
+
+// The current chunk stays last, after the adopted ones.
+void Arena::adopt(Arena&& other) {
+    auto position = cursor ? chunks.end() - 1 : chunks.end();
+    chunks.insert(position, std::make_move_iterator(other.chunks.begin()), std::make_move_iterator(other.chunks.end()));
+    allocations += other.allocations;
+    bytesUsed += other.bytesUsed;
+
+    other.chunks.clear();
+    other.cursor = other.limit = nullptr;
+    other.allocations = other.bytesUsed = 0;
+}
+
+void Arena::reset() {
+    if (chunks.size() > 1) {
+        chunks.erase(chunks.begin(), chunks.end() - 1);
+    }
+    if (!chunks.empty()) {
+        cursor = chunks.back().get();
+    }
+    allocations = bytesUsed = 0;
+}
@@ -0,0 +1,45 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_ARENA_H
+#define GO_TO_TS_SIMPLE_COMPILER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+// Bump allocator owning the text of one compilation unit that the AST cannot view in the source: decoded string
+// literals, and every literal of a streamed input. Memory comes from large chunks that are released together when
+// the arena is destroyed.
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    std::string_view copyString(std::string_view text);
+    // Takes ownership of everything `other` has allocated, leaving it empty. Allocation continues in this arena's
+    // current chunk.
+    void adopt(Arena&& other);
+    // Frees everything allocated so far. The current chunk is kept for reuse.
+    void reset();
+
+    inline size_t allocationCount() const { return allocations; }
+    inline size_t bytesAllocated() const { return bytesUsed; }
+    inline size_t chunkCount() const { return chunks.size(); }
+
+private:
+    static constexpr size_t minChunkSize = 64 << 10;
+    static constexpr size_t maxChunkSize = 4 << 20;
+
+    std::vector<std::unique_ptr<char[]>> chunks;
+    char* cursor = nullptr;
+    char* limit = nullptr;
+    size_t nextChunkSize = minChunkSize;
+    size_t allocations = 0;
+    size_t bytesUsed = 0;
+
+    void* allocate(size_t size, size_t alignment);
+    void addChunk(size_t minimum);
+};
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_ARENA_H
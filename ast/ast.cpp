@@ -4,233 +4,407 @@
 
 #include "ast.h"
 
-std::string Program::testString() {
-    std::stringstream ss;
+#include <algorithm>
+#include <charconv>
+#include <sstream>
 
-    for (auto& stmt : nodes) {
-        ss << stmt->testString();
-    }
-
-    return ss.str();
+NodeId Program::addInteger(int64_t value) {
+    return addLiteral(NODE_INTEGER, static_cast<uint64_t>(value));
 }
 
-std::string Program::string() {
-    return std::string();
+NodeId Program::addFloat(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return addLiteral(NODE_FLOAT, bits);
 }
 
-std::string ReturnNode::testString() {
-    std::stringstream ss;
-
-    ss << "ReturnNode(";
-
-    if (value) {
-        ss << value->testString();
-    } else {
-        ss << "EMPTY";
-    }
-
-    ss << ")";
-
-    return ss.str();
+int64_t Program::integerValue(NodeId id) const {
+    return static_cast<int64_t>(nodes[id].payload());
 }
 
-std::string Prefix::testString() {
-    std::stringstream ss;
-
-    ss << "(" << Operator << right->testString() << ")";
-
-    return ss.str();
+double Program::floatValue(NodeId id) const {
+    uint64_t bits = nodes[id].payload();
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
 }
 
-std::string Prefix::string() {
-    std::stringstream ss;
-
-    ss << "Prefix(" << Operator << right->testString() << ")";
-
-    return ss.str();
-}
-
-std::string Infix::testString() {
-    std::stringstream ss;
-
-    ss << "(" << left->testString() << " " + Operator + " " << right->testString() << ")";
-
-    return ss.str();
+// Shortest text that reads back as the same double, which is also a valid TypeScript number.
+static void appendFloat(double value, std::string& out) {
+    char buffer[32];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
 }
 
-std::string Infix::string() {
-    std::stringstream ss;
-
-    ss << left->string() << " " + Operator + " " << right->string();
-
-    return ss.str();
-}
-
-std::string RValue::testString() {
-    if (value) { return "RValue(" + value->testString() + ")"; }
-    return "";
-}
-
-std::string CodeBlock::testString() {
-    std::ostringstream out;
+// Quotes a decoded value as a TypeScript string literal. Values with nothing to escape, the common case, are
+// copied as they are; UTF-8 passes through unchanged.
+static void appendQuoted(std::string_view value, std::string& out) {
+    auto needsEscape = [](unsigned char c) { return c == '"' || c == '\\' || c < 0x20 || c == 0x7F; };
+    out += '"';
+    if (std::none_of(value.begin(), value.end(), needsEscape)) {
+        out += value;
+        out += '"';
+        return;
+    }
 
-    for (const auto& s : nodes) {
-        if (s) {
-            out << s->testString();
+    out.reserve(out.length() + value.length() + 8);
+    for (unsigned char c : value) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (needsEscape(c)) {
+                    static const char digits[] = "0123456789abcdef";
+                    out += "\\x";
+                    out += digits[c >> 4];
+                    out += digits[c & 0xF];
+                } else {
+                    out += static_cast<char>(c);
+                }
         }
     }
-
-    return out.str();
+    out += '"';
 }
 
-std::string IfElseNode::testString() {
-    std::ostringstream out;
-
-    out << "IfStatement(";
-    if (condition) {
-        out << "Condition(" << condition->testString() << ")";
-    } else {
-        out << "Condition()";
-    }
-    out << " ";
-    if (consequence) {
-        out << "Consequence(" << consequence->testString() << ")";
-    } else {
-        out << "Consequence()";
-    }
+NodeRange Program::addValues(const std::vector<uint64_t>& payloads) {
+    NodeRange range{static_cast<uint32_t>(values.size()), static_cast<uint32_t>(payloads.size())};
+    values.insert(values.end(), payloads.begin(), payloads.end());
+    return range;
+}
 
-    if (alternative) {
-        out << " Alternative(";
-        out << alternative->testString() << ")";
-    } else {
-        out << " Alternative()";
+// Which fields of a node refer to other nodes, by kind, following the field table in ast.h.
+enum NodeFields : uint8_t {
+    LHS_NODE = 1 << 0,
+    RHS_NODE = 1 << 1,
+    EXTRA_NODE = 1 << 2,
+    LIST_NODES = 1 << 3,
+};
+
+static uint8_t nodeFields(NodeKind kind) {
+    switch (kind) {
+        case NODE_ARRAY:
+        case NODE_CODE_BLOCK:
+        case NODE_PRINT:
+            return LIST_NODES;
+        case NODE_DECLARATION:
+            return LHS_NODE | RHS_NODE | LIST_NODES;
+        case NODE_ASSIGNMENT:
+        case NODE_INFIX:
+        case NODE_INDEX:
+            return LHS_NODE | RHS_NODE;
+        case NODE_RETURN:
+        case NODE_RVALUE:
+            return LHS_NODE;
+        case NODE_IF_ELSE:
+            return LHS_NODE | RHS_NODE | EXTRA_NODE;
+        case NODE_PREFIX:
+            return RHS_NODE;
+        case NODE_FUNCTION:
+        case NODE_FUNCTION_CALL:
+            return RHS_NODE | LIST_NODES;
+        default:
+            return 0;
     }
-    out << ")";
-
-    return out.str();
 }
 
-std::string Function::testString() {
-    std::ostringstream out;
-
-    out << "Function(";
-    if (!funcName.empty()) {
-        out << "Name(" << funcName << ")";
-    } else {
-        out << "Name()";
+void Program::append(Program&& part) {
+    auto nodeBase = static_cast<NodeId>(nodes.size() - 1);
+    auto listBase = static_cast<uint32_t>(lists.size());
+    auto textBase = static_cast<uint32_t>(texts.size() - 1);
+    auto valueBase = static_cast<uint32_t>(values.size());
+    auto shift = [&](NodeId id) { return id ? id + nodeBase : NO_NODE; };
+
+    // An array type is always interned after its element type, so the element is already mapped.
+    std::vector<TypeId> typeMap(part.types.size());
+    for (TypeId type = 0; type < part.types.size(); type++) {
+        typeMap[type] = part.types.isArray(type) ? types.arrayOf(typeMap[part.types.element(type)]) : type;
     }
-    out << " Params(";
 
-    for (size_t i = 0; i < parameters.size(); ++i) {
-        out << parameters[i]->testString();
-        if (i < parameters.size() - 1) {
-            out << ", ";
+    texts.insert(texts.end(), part.texts.begin() + 1, part.texts.end());
+    values.insert(values.end(), part.values.begin(), part.values.end());
+
+    for (size_t i = 1; i < part.nodes.size(); i++) {
+        auto n = part.nodes[i];
+        auto fields = nodeFields(n.kind);
+        n.type = typeMap[n.type];
+        if (fields & LHS_NODE) n.lhs = shift(n.lhs);
+        if (fields & RHS_NODE) n.rhs = shift(n.rhs);
+        if (fields & EXTRA_NODE) n.extra = shift(n.extra);
+        if (n.kind == NODE_STRING && n.lhs) n.lhs += textBase;
+        if (n.holdsPackedElements()) {
+            n.list.start += valueBase;
+            if (n.extra == NODE_STRING) {
+                for (uint32_t j = 0; j < n.list.count; j++) values[n.list.start + j] += textBase;
+            }
+        } else if (fields & LIST_NODES) {
+            n.list.start += listBase;
         }
+        nodes.push_back(n);
     }
 
-    out << ") Body(";
-    if (body) {
-        out << body->testString();
+    for (auto id : part.lists) {
+        lists.push_back(shift(id));
     }
-
-    out << "))";
-
-    return out.str();
-}
-
-std::string FunctionCall::testString() {
-    std::ostringstream out;
-
-    std::vector<std::string> arguments;
-    arguments.reserve(args.size());
-    for (const auto& arg : args) {
-        arguments.push_back(arg->testString());
-    }
-
-    std::string argumentsString;
-    for (auto i=0; i<arguments.size(); i++) {
-        if (i != arguments.size()-1) {
-        argumentsString += arguments[i] + ", ";
-        } else {
-            argumentsString += arguments[i] + ")";
-        }
+    for (auto statement : part.statements) {
+        statements.push_back(shift(statement));
     }
+    arena.adopt(std::move(part.arena));
+}
 
-    out << "FunctionCall(" + funcName << "(" << argumentsString + ")";
+void Program::discardNodes() {
+    nodes.resize(1);
+    lists.clear();
+    texts.resize(1);
+    values.clear();
+    statements.clear();
+    arena.reset();
+}
 
-    return out.str();
+NodeId Program::addLiteral(NodeKind kind, uint64_t payload) {
+    auto id = add(kind);
+    nodes[id].lhs = static_cast<uint32_t>(payload);
+    nodes[id].rhs = static_cast<uint32_t>(payload >> 32);
+    nodes[id].type = literalType(kind);
+    return id;
 }
 
-std::string FunctionCall::string() {
-    std::ostringstream out;
-    out << funcName << "(";
-    for (int i=0; i<args.size(); i++) {
-        if (i<args.size()-1) {
-            out<<args[i]->string()<<", ";
-        } else {
-            out<<args[i]->string();
+void Program::appendLiteral(NodeKind kind, uint64_t payload, std::string& out) const {
+    switch (kind) {
+        case NODE_INTEGER: {
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<int64_t>(payload));
+            out.append(buffer, result.ptr);
+            break;
+        }
+        case NODE_FLOAT: {
+            double value;
+            std::memcpy(&value, &payload, sizeof(value));
+            appendFloat(value, out);
+            break;
         }
+        case NODE_STRING:
+            appendQuoted(text(static_cast<uint32_t>(payload)), out);
+            break;
+        case NODE_BOOLEAN:
+            out += boolToString(payload != 0);
+            break;
+        default:
+            break;
     }
-    out << ")";
-    return out.str();
 }
 
-std::string Array::string() {
-    std::ostringstream out;
+std::string Program::string(NodeId id) const {
+    std::string out;
+    appendString(id, out);
+    return out;
+}
 
-    std::vector<std::string> arguments;
-    arguments.reserve(elements.size());
-    for (const auto& arg : elements) {
-        arguments.push_back(arg->string());
-    }
+// Renders with an explicit stack of pending nodes and separators, appending to one buffer, so a long operator
+// chain costs time linear in its length and no native stack. Children are pushed in reverse order.
+void Program::appendString(NodeId id, std::string& out) const {
+    struct Item {
+        NodeId node;
+        std::string_view text;
+    };
+    std::vector<Item> pending{{id, {}}};
+
+    auto pushList = [&](NodeRange list, std::string_view close) {
+        pending.push_back({NO_NODE, close});
+        for (uint32_t i = list.count; i-- > 0;) {
+            pending.push_back({child(list, i), {}});
+            if (i != 0) pending.push_back({NO_NODE, ", "});
+        }
+    };
+
+    while (!pending.empty()) {
+        auto item = pending.back();
+        pending.pop_back();
+        if (!item.node) {
+            out += item.text;
+            continue;
+        }
 
-    std::string elementsString;
-    for (auto i=0; i<arguments.size(); i++) {
-        if (i != arguments.size()-1) {
-            elementsString += arguments[i] + ", ";
-        } else {
-            elementsString += arguments[i];
+        const auto& n = nodes[item.node];
+        switch (n.kind) {
+            case NODE_INTEGER:
+            case NODE_FLOAT:
+            case NODE_STRING:
+            case NODE_BOOLEAN:
+                appendLiteral(n.kind, n.payload(), out);
+                break;
+            case NODE_ARRAY:
+                out += '[';
+                if (n.holdsPackedElements()) {
+                    auto elementKind = static_cast<NodeKind>(n.extra);
+                    for (uint32_t i = 0; i < n.list.count; i++) {
+                        if (i != 0) out += ", ";
+                        appendLiteral(elementKind, value(n.list, i), out);
+                    }
+                    out += ']';
+                } else {
+                    pushList(n.list, "]");
+                }
+                break;
+            case NODE_IDENTIFIER:
+                out += name(n.lhs);
+                break;
+            case NODE_FUNCTION_CALL:
+                pushList(n.list, ")");
+                pending.push_back({NO_NODE, "("});
+                if (n.lhs) {
+                    out += name(n.lhs);
+                } else {
+                    pending.push_back({n.rhs, {}});
+                }
+                break;
+            case NODE_DECLARATION:
+            case NODE_RETURN:
+            case NODE_RVALUE:
+                pending.push_back({n.lhs, {}});
+                break;
+            case NODE_ASSIGNMENT:
+                pending.push_back({n.rhs, {}});
+                pending.push_back({NO_NODE, " = "});
+                pending.push_back({n.lhs, {}});
+                break;
+            case NODE_CODE_BLOCK:
+                out += "CODE_BLOCK";
+                break;
+            case NODE_IF_ELSE:
+                out += "IF_STATEMENT";
+                break;
+            case NODE_PREFIX: {
+                // An operator operand is parenthesised, so that -(a + b) keeps its grouping and - -a does not
+                // read as a decrement.
+                out += tokenTypeName(n.op);
+                auto operandKind = kind(n.rhs);
+                bool group = operandKind == NODE_PREFIX || operandKind == NODE_INFIX;
+                if (group) pending.push_back({NO_NODE, ")"});
+                pending.push_back({n.rhs, {}});
+                if (group) out += '(';
+                break;
+            }
+            case NODE_INFIX:
+                pending.push_back({n.rhs, {}});
+                pending.push_back({NO_NODE, " "});
+                pending.push_back({NO_NODE, tokenTypeName(n.op)});
+                pending.push_back({NO_NODE, " "});
+                pending.push_back({n.lhs, {}});
+                break;
+            case NODE_FUNCTION:
+                out += "FUNCTION";
+                break;
+            case NODE_INDEX:
+                pending.push_back({NO_NODE, "]"});
+                pending.push_back({n.rhs, {}});
+                pending.push_back({NO_NODE, "["});
+                pending.push_back({n.lhs, {}});
+                break;
+            case NODE_PRINT:
+                out += "console.log()";
+                break;
+            case NODE_NONE:
+                break;
         }
     }
-
-    out <<  "[" << elementsString << "]";
-
-    return out.str();
 }
 
-std::string Array::testString() {
-    std::ostringstream out;
-
-    std::vector<std::string> arguments;
-    arguments.reserve(elements.size());
-    for (const auto& arg : elements) {
-        arguments.push_back(arg->testString());
-    }
-
-    std::string elementsString;
-    for (auto i=0; i<arguments.size(); i++) {
-        if (i != arguments.size()-1) {
-            elementsString += arguments[i] + ", ";
-        } else {
-            elementsString += arguments[i] + "]";
-        }
+static const char* literalKindName(NodeKind kind) {
+    switch (kind) {
+        case NODE_INTEGER: return "Integer";
+        case NODE_FLOAT: return "Float";
+        case NODE_STRING: return "String";
+        default: return "Boolean";
     }
-
-    out <<  "Array([" << elementsString << ")";
-
-    return out.str();
 }
 
-std::string Index::testString() {
+std::string Program::testString(NodeId id) const {
+    const auto& n = nodes[id];
     std::ostringstream out;
 
-    out << "IndexExpression(" << "Left:(" + left->testString() + ")" << " Right: [" << index->testString() << "])";
+    switch (n.kind) {
+        case NODE_INTEGER:
+        case NODE_FLOAT:
+        case NODE_STRING:
+        case NODE_BOOLEAN:
+            return std::string(literalKindName(n.kind)) + "(" + string(id) + ")";
+        case NODE_ARRAY:
+            out << "Array([";
+            for (uint32_t i = 0; i < n.list.count; i++) {
+                if (n.holdsPackedElements()) {
+                    std::string element;
+                    appendLiteral(static_cast<NodeKind>(n.extra), value(n.list, i), element);
+                    out << literalKindName(static_cast<NodeKind>(n.extra)) << "(" << element << ")";
+                } else {
+                    out << testString(child(n.list, i));
+                }
+                out << (i + 1 < n.list.count ? ", " : "]");
+            }
+            out << ")";
+            return out.str();
+        case NODE_IDENTIFIER:
+            return "Identifier(" + string(id) + ")";
+        case NODE_DECLARATION:
+            return "Declaration: " + string(n.lhs);
+        case NODE_ASSIGNMENT:
+            return "Assignment(" + string(n.lhs) + " = " + string(n.rhs) + ")";
+        case NODE_RETURN:
+            return "ReturnNode(" + (n.lhs ? testString(n.lhs) : std::string("EMPTY")) + ")";
+        case NODE_RVALUE:
+            return n.lhs ? "RValue(" + testString(n.lhs) + ")" : "";
+        case NODE_CODE_BLOCK:
+            for (uint32_t i = 0; i < n.list.count; i++) {
+                out << testString(child(n.list, i));
+            }
+            return out.str();
+        case NODE_IF_ELSE:
+            out << "IfStatement(Condition(" << testString(n.lhs) << ") Consequence(" << testString(n.rhs) << ")";
+            if (n.extra) {
+                out << " Alternative(" << testString(n.extra) << ")";
+            } else {
+                out << " Alternative()";
+            }
+            out << ")";
+            return out.str();
+        case NODE_PREFIX:
+            return std::string("(") + tokenTypeName(n.op) + testString(n.rhs) + ")";
+        case NODE_INFIX:
+            return "(" + testString(n.lhs) + " " + tokenTypeName(n.op) + " " + testString(n.rhs) + ")";
+        case NODE_FUNCTION:
+            out << "Function(Name(" << name(n.lhs) << ") Params(";
+            for (uint32_t i = 0; i < n.list.count; i++) {
+                out << testString(child(n.list, i)) << (i + 1 < n.list.count ? ", " : "");
+            }
+            out << ") Body(" << testString(n.rhs) << "))";
+            return out.str();
+        case NODE_FUNCTION_CALL:
+            out << "FunctionCall(" << (n.lhs ? std::string(name(n.lhs)) : testString(n.rhs)) << "(";
+            for (uint32_t i = 0; i < n.list.count; i++) {
+                out << testString(child(n.list, i)) << (i + 1 < n.list.count ? ", " : ")");
+            }
+            out << ")";
+            return out.str();
+        case NODE_INDEX:
+            return "IndexExpression(Left:(" + testString(n.lhs) + ") Right: [" + testString(n.rhs) + "])";
+        case NODE_PRINT:
+            return "OUTPUTNODE ()";
+        case NODE_NONE:
+            break;
+    }
+    return "";
+}
 
-    return out.str();
+std::string Program::testString() const {
+    std::string out;
+    for (auto statement : statements) {
+        out += testString(statement);
+    }
+    return out;
 }
 
 std::string boolToString(bool boolV) {
     if (boolV) { return "true";} else { return "false"; }
 }
-
-
@@ -5,266 +5,178 @@
 #ifndef GO_TO_TS_SIMPLE_COMPILER_AST_H
 #define GO_TO_TS_SIMPLE_COMPILER_AST_H
 
-#include <utility>
-#include <vector>
-#include <sstream>
+#include <cstdint>
+#include <cstring>
 #include <memory>
-#include "string"
+#include <string>
+#include <string_view>
+#include <vector>
 #include "../token/token.h"
+#include "arena.h"
+#include "typeTable.h"
 
 std::string boolToString(bool boolV);
 
-struct TypeNode {
-    virtual ~TypeNode() = default;
-    virtual TokenType getType() = 0;
-    virtual TokenType getSubType() = 0;
-    virtual std::unique_ptr<TypeNode> clone() const = 0;
-};
-
-struct StringType : public TypeNode {
-    TokenType getType() override  {return STRING_TYPE;}
-    TokenType getSubType() override  {return NOTYPE_TYPE;}
-    std::unique_ptr<TypeNode> clone() const override {
-        return std::make_unique<StringType>(*this);
+// Nodes are addressed by 32-bit index into Program::nodes. Index 0 is a sentinel, so NO_NODE plays the part of a
+// null child and zero-initialised fields mean "none".
+using NodeId = uint32_t;
+constexpr NodeId NO_NODE = 0;
+
+enum NodeKind : uint8_t {
+    NODE_NONE,
+    NODE_INTEGER,
+    NODE_FLOAT,
+    NODE_STRING,
+    NODE_BOOLEAN,
+    NODE_ARRAY,
+    NODE_IDENTIFIER,
+    NODE_DECLARATION,
+    NODE_ASSIGNMENT,
+    NODE_RETURN,
+    NODE_RVALUE,
+    NODE_CODE_BLOCK,
+    NODE_IF_ELSE,
+    NODE_PREFIX,
+    NODE_INFIX,
+    NODE_FUNCTION,
+    NODE_FUNCTION_CALL,
+    NODE_INDEX,
+    NODE_PRINT,
+};
+
+// Kinds are ordered so that these groups are contiguous ranges.
+inline bool isLiteralKind(NodeKind kind) { return kind >= NODE_INTEGER && kind <= NODE_BOOLEAN; }
+inline bool isValueKind(NodeKind kind) { return kind >= NODE_INTEGER && kind <= NODE_ARRAY; }
+
+inline TypeId literalType(NodeKind kind) {
+    switch (kind) {
+        case NODE_INTEGER: return TYPE_INT;
+        case NODE_FLOAT: return TYPE_FLOAT;
+        case NODE_STRING: return TYPE_STRING;
+        case NODE_BOOLEAN: return TYPE_BOOL;
+        default: return NO_TYPE;
     }
-};
+}
 
-struct IntegerType : public TypeNode {
-    TokenType getType() override  {return INT_TYPE;}
-    TokenType getSubType() override  {return NOTYPE_TYPE;}
-    std::unique_ptr<TypeNode> clone() const override {
-        return std::make_unique<IntegerType>(*this);
-    }
+enum NodeFlags : uint8_t {
+    HOLDS_VALUE = 1 << 0,
+    HOLDS_MULTIPLE_VALUES = 1 << 1,
+    IS_CONSTANT = 1 << 2,
+    PACKED_ELEMENTS = 1 << 3,
+    DEFERRED_BODY = 1 << 4,
 };
 
-struct BoolType : public TypeNode {
-    TokenType getType() override  {return BOOL_TYPE;}
-    TokenType getSubType() override  {return NOTYPE_TYPE;}
-    std::unique_ptr<TypeNode> clone() const override {
-        return std::make_unique<BoolType>(*this);
-    }
-};
-
-struct ArrayType : public TypeNode {
-    std::unique_ptr<TypeNode> subType;
-    explicit ArrayType(std::unique_ptr<TypeNode> type) : subType(std::move(type)) {};
-    ArrayType() = default;
-    TokenType getType() override  {return ARRAY_TYPE;}
-    TokenType getSubType() override  {return subType->getType();}
-    std::unique_ptr<TypeNode> clone() const override {
-        return std::make_unique<ArrayType>(subType ? subType->clone() : nullptr);
-    }
-};
+// A run of children in Program::lists.
+struct NodeRange {
+    uint32_t start = 0;
+    uint32_t count = 0;
 
-struct NoType : public TypeNode {
-    TokenType getType() override  {return NOTYPE_TYPE;}
-    TokenType getSubType() override  {return NOTYPE_TYPE;}
-    std::unique_ptr<TypeNode> clone() const override {
-        return std::make_unique<NoType>(*this);
-    }
+    inline bool empty() const { return count == 0; }
 };
 
-struct Node {
-    bool holdsValue = true;
-    bool holdsMultipleValues = false;
-    std::unique_ptr<TypeNode> type;
-
-    virtual ~Node() = default;
-    virtual std::string testString() = 0;
-    virtual std::string string() = 0;
-};
+// A literal's value is its 64-bit payload split over lhs (low half) and rhs (high half): the integer, the bits of
+// the double, the text index of a string or 0/1 for a boolean. Literal-only array literals keep just the payloads.
+//
+// One fixed-size record per node. Field use by kind (unused fields stay zero):
+//   INTEGER, FLOAT   lhs, rhs: low and high 32 bits of the value
+//   STRING           lhs: text of the decoded value
+//   BOOLEAN          lhs: the value
+//   IDENTIFIER       lhs: symbol of the name; type: declared parameter type
+//   ARRAY            list: elements; with PACKED_ELEMENTS, a range of Program::values, extra: their literal kind
+//   DECLARATION      lhs: name, rhs: value, list: grouped declarations
+//   ASSIGNMENT       lhs: variable, rhs: value
+//   RETURN, RVALUE   lhs: value
+//   CODE_BLOCK       list: statements
+//   IF_ELSE          lhs: condition, rhs: consequence, extra: alternative
+//   PREFIX           op, rhs: operand
+//   INFIX            op, lhs, rhs
+//   FUNCTION         lhs: symbol of the name, rhs: body, list: parameters; with DEFERRED_BODY, no body yet and
+//                    extra: token index of its opening brace
+//   FUNCTION_CALL    lhs: symbol of the name, or NO_SYMBOL and rhs: the callee expression, list: arguments
+//   INDEX            lhs: indexed value, rhs: index
+//   PRINT            list: values
+struct AstNode {
+    NodeKind kind = NODE_NONE;
+    uint8_t flags = HOLDS_VALUE;
+    TokenType op = ILLEGAL;
+    TypeId type = NO_TYPE;
+    uint32_t lhs = 0;
+    uint32_t rhs = 0;
+    uint32_t extra = 0;
+    NodeRange list;
+
+    inline bool holdsValue() const { return flags & HOLDS_VALUE; }
+    inline bool holdsMultipleValues() const { return flags & HOLDS_MULTIPLE_VALUES; }
+    inline bool isConstant() const { return flags & IS_CONSTANT; }
+    inline bool holdsPackedElements() const { return flags & PACKED_ELEMENTS; }
+    inline bool hasDeferredBody() const { return flags & DEFERRED_BODY; }
+    inline uint64_t payload() const { return static_cast<uint64_t>(rhs) << 32 | lhs; }
+};
+
+// The AST of one compilation unit, stored as flat arrays: node records, the child lists they refer to by range,
+// and the string values they refer to by index, text 0 being empty. Texts are views into the source, or into the
+// arena when they had to be copied or decoded. Node types are ids into `types`, and names are ids into `symbols`,
+// the table shared with the lexer. Node references are invalidated when a node is added, so hold ids rather than
+// AstNode references across parsing calls.
+struct Program {
+    Arena arena;
+    TypeTable types;
+    std::shared_ptr<SymbolTable> symbols;
+    std::vector<AstNode> nodes{1};
+    std::vector<NodeId> lists;
+    std::vector<std::string_view> texts{1};
+    std::vector<uint64_t> values;
+    std::vector<NodeId> statements;
 
-struct Program : public Node {
-    std::vector<std::unique_ptr<Node>> nodes;
     Program() = default;
-    ~Program() override = default;
     Program(const Program&) = delete;
     Program& operator=(const Program&) = delete;
-    Program(Program&&) noexcept = delete;
-    Program& operator=(Program&&) noexcept = delete;
-
-    std::string string() override;
-    std::string testString() override;
-};
-
-struct ValueNode : public Node {
-    std::unique_ptr<TypeNode> type;
-
-    explicit ValueNode(std::unique_ptr<TypeNode> initType) : type(std::move(initType)) {}
-
-    ~ValueNode() override = default;
-};
-
-struct Integer : public ValueNode {
-    int value{};
-
-    Integer() : ValueNode(std::make_unique<IntegerType>()) {};
-
-    inline std::string string() override {return std::to_string(value);}
-    inline std::string testString() override { return "Integer(" + string() + ")"; }
-};
-
-struct String : public ValueNode {
-    std::string value;
-
-    explicit String(std::string val) : ValueNode(std::make_unique<StringType>()), value(std::move(val)) {}
-    String() : ValueNode(std::make_unique<StringType>()) {};
-
-    inline std::string string() override {return "\"" + value + "\"";}
-    inline std::string testString() override { return "String(" + string() + ")"; }
-};
-
-struct Boolean : public ValueNode {
-    bool value{};
-
-    explicit Boolean(bool val) : ValueNode(std::make_unique<BoolType>()), value(val) {}
-    Boolean() : ValueNode(std::make_unique<BoolType>()) {};
-
-    inline std::string string() override {return boolToString(value);}
-    inline std::string testString() override { return "Boolean(" + string() + ")"; }
-};
-
-struct Array : public ValueNode {
-    std::vector<std::unique_ptr<Node>> elements;
-
-    explicit Array(std::unique_ptr<TypeNode> type) : ValueNode(std::move(type)) {};
-    Array() : ValueNode(std::make_unique<ArrayType>()) {};
-
-    std::string string() override;
-    std::string testString() override;
-};
-
-struct Identifier : public Node {
-    std::string name;
-    std::unique_ptr<TypeNode> type;
-    explicit Identifier(std::string name) : name(std::move(name)) {}
-
-    inline std::string string() override {return name;}
-    inline std::string testString() override { return "Identifier(" + name + ")"; }
-};
-
-struct Declaration : public Node {
-    std::unique_ptr<Node> name;
-    std::unique_ptr<Node> value;
-    std::vector<std::unique_ptr<Declaration>> multipleValues;
-    std::unique_ptr<TypeNode> type;
-    bool isConstant = false;
-
-    Declaration() = default;
-
-    inline std::string string()  override {return name->string();}
-    std::string testString() override {return "Declaration: " + name->string();}
-};
 
-struct Assignment : public Node {
-    std::unique_ptr<Node> variable;
-    std::unique_ptr<Node> value;
+    inline AstNode& node(NodeId id) { return nodes[id]; }
+    inline const AstNode& node(NodeId id) const { return nodes[id]; }
+    inline NodeKind kind(NodeId id) const { return nodes[id].kind; }
 
-    Assignment() = default;
-
-    inline std::string string()  override {return variable->string() + " = " + value->string();}
-    std::string testString() override {return "Assignment(" + variable->string() + " = " + value->string() + ")";}
-};
-
-struct ReturnNode : public Node {
-    std::unique_ptr<Node> value;
-
-    ReturnNode() = default;
-
-    inline std::string string() override {return value->string();}
-    std::string testString() override;
-};
-
-struct RValue : public Node {
-    std::unique_ptr<Node> value;
-
-    RValue() = default;
-
-    inline std::string string() override {return value->string();}
-    std::string testString() override;
-};
-
-struct CodeBlock : public Node {
-    std::vector<std::unique_ptr<Node>> nodes;
-
-    CodeBlock() = default;
-
-    inline std::string string() override {return "CODE_BLOCK";}
-    std::string testString() override;
-};
-
-struct IfElseNode : public Node {
-    std::unique_ptr<Node> condition;
-    std::unique_ptr<CodeBlock> consequence;
-    std::unique_ptr<CodeBlock> alternative;
-
-    IfElseNode() = default;
-
-    inline std::string string() override {return "IF_STATEMENT";}
-    std::string testString() override;
-};
-
-struct Prefix : public Node {
-    std::string Operator;
-    std::unique_ptr<Node> right;
-
-    explicit Prefix(std::string Operator) : Operator(std::move(Operator)) {};
-
-    inline std::string string() override;
-    std::string testString() override;
-};
-
-struct Infix : public Node {
-    std::string Operator;
-    std::unique_ptr<Node> right;
-    std::unique_ptr<Node> left;
-
-    Infix(std::string Operator, std::unique_ptr<Node> left) : Operator(std::move(Operator)), left(std::move(left)) {};
-
-    std::string string() override;
-    std::string testString() override;
-};
-
-struct Function : public Node {
-    std::vector<std::unique_ptr<Identifier>> parameters;
-    std::unique_ptr<CodeBlock> body;
-    std::string funcName;
-    std::unique_ptr<TypeNode> type;
-
-    Function() = default;
-
-    inline std::string string() override {return "FUNCTION";}
-    std::string testString() override;
-};
-
-struct FunctionCall : public Node {
-    std::string funcName;
-    std::vector<std::unique_ptr<Node>> args;
-
-    explicit FunctionCall(std::string funcName) : funcName(std::move(funcName)) {};
-
-    std::string string() override;
-    std::string testString() override;
-};
-
-struct Index : public Node {
-    std::unique_ptr<Node> left;
-    std::unique_ptr<Node> index;
-
-    explicit Index(std::unique_ptr<Node> left) : left(std::move(left)) {};
-
-    inline std::string string() override {return left->string() + "[" + index->string() + "]";}
-    std::string testString() override;
-};
-
-struct PrintNode : public Node {
-    std::vector<std::unique_ptr<Node>> values{};
-
-    PrintNode() = default;
+    inline NodeId add(NodeKind kind) {
+        nodes.emplace_back().kind = kind;
+        return static_cast<NodeId>(nodes.size() - 1);
+    }
 
-    inline std::string string() override {return "console.log()";}
-    inline std::string testString() {return "OUTPUTNODE ()";};
+    inline NodeRange addList(const std::vector<NodeId>& children) {
+        NodeRange range{static_cast<uint32_t>(lists.size()), static_cast<uint32_t>(children.size())};
+        lists.insert(lists.end(), children.begin(), children.end());
+        return range;
+    }
+    inline NodeId child(NodeRange range, size_t i) const { return lists[range.start + i]; }
+    NodeRange addValues(const std::vector<uint64_t>& payloads);
+    inline uint64_t value(NodeRange range, size_t i) const { return values[range.start + i]; }
 
+    inline uint32_t addText(std::string_view text) {
+        texts.push_back(text);
+        return static_cast<uint32_t>(texts.size() - 1);
+    }
+    inline std::string_view text(uint32_t index) const { return texts[index]; }
+    inline std::string_view name(SymbolId symbol) const { return symbols->name(symbol); }
+
+    // Moves a Program parsed separately, with the same symbol table, onto the end of this one: its nodes, lists,
+    // texts, values and statements are appended with their ids shifted, its types are re-interned here and its
+    // arena is adopted. Statements keep their order, so parts appended in source order read as one Program.
+    void append(Program&& part);
+    // Drops every node, list, text, value and statement, and what the arena holds, keeping their capacity for the
+    // next statement. Types and symbols are kept, so ids already handed out for them stay valid.
+    void discardNodes();
+
+    NodeId addLiteral(NodeKind kind, uint64_t payload);
+    NodeId addInteger(int64_t value);
+    NodeId addFloat(double value);
+    int64_t integerValue(NodeId id) const;
+    double floatValue(NodeId id) const;
+
+    // Source-like rendering used by the compiler, and the structural dump used when debugging the parser.
+    std::string string(NodeId id) const;
+    void appendString(NodeId id, std::string& out) const;
+    void appendLiteral(NodeKind kind, uint64_t payload, std::string& out) const;
+    std::string testString(NodeId id) const;
+    std::string testString() const;
 };
 
 #endif //GO_TO_TS_SIMPLE_COMPILER_AST_H
@@ -0,0 +1,44 @@
+#include "typeTable.h"
+
+#include <limits>
+#include <string>
+#include <stdexcept>
+
+TypeTable::TypeTable() {
+    types = {
+            {ILLEGAL, NO_TYPE},
+            {INT_TYPE, NO_TYPE},
+            {FLOAT_TYPE, NO_TYPE},
+            {STRING_TYPE, NO_TYPE},
+            {BOOL_TYPE, NO_TYPE},
+            {NOTYPE_TYPE, NO_TYPE},
+    };
+    arrayTypes.resize(types.size(), NO_TYPE);
+}
+
+TypeId TypeTable::primitive(TokenType kind) {
+    switch (kind) {
+        case INT_TYPE: return TYPE_INT;
+        case FLOAT_TYPE: return TYPE_FLOAT;
+        case STRING_TYPE: return TYPE_STRING;
+        case BOOL_TYPE: return TYPE_BOOL;
+        case NOTYPE_TYPE: return TYPE_VOID;
+        default:
+            throw std::runtime_error(std::string("Not a primitive type: ") + tokenTypeName(kind));
+    }
+}
+
+TypeId TypeTable::arrayOf(TypeId element) {
+    if (arrayTypes[element] != NO_TYPE) {
+        return arrayTypes[element];
+    }
+    if (types.size() > std::numeric_limits<TypeId>::max()) {
+        throw std::runtime_error("Too many distinct types");
+    }
+
+    auto id = static_cast<TypeId>(types.size());
+    types.push_back({ARRAY_TYPE, element});
+    arrayTypes.push_back(NO_TYPE);
+    arrayTypes[element] = id;
+    return id;
+}
@@ -0,0 +1,47 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_TYPETABLE_H
+#define GO_TO_TS_SIMPLE_COMPILER_TYPETABLE_H
+
+#include <cstdint>
+#include <vector>
+#include "../token/token.h"
+
+// Types are interned: every distinct type is stored once and referred to by a small id, so two types are equal
+// exactly when their ids are.
+using TypeId = uint16_t;
+
+// The primitive types have fixed ids. NO_TYPE means "no type recorded yet".
+enum BuiltinType : TypeId {
+    NO_TYPE,
+    TYPE_INT,
+    TYPE_FLOAT,
+    TYPE_STRING,
+    TYPE_BOOL,
+    TYPE_VOID,
+    BUILTIN_TYPE_COUNT,
+};
+
+struct TypeInfo {
+    TokenType kind;
+    TypeId element;
+};
+
+class TypeTable {
+public:
+    TypeTable();
+
+    // Id of a primitive type given its type token (INT_TYPE, STRING_TYPE, ...).
+    static TypeId primitive(TokenType kind);
+    // Id of the array type with the given element type, interning it on first use.
+    TypeId arrayOf(TypeId element);
+
+    inline TokenType kind(TypeId type) const { return types[type].kind; }
+    inline TypeId element(TypeId type) const { return types[type].element; }
+    inline bool isArray(TypeId type) const { return types[type].kind == ARRAY_TYPE; }
+    inline size_t size() const { return types.size(); }
+private:
+    std::vector<TypeInfo> types;
+    // Array type of each type id, or NO_TYPE while it has not been interned.
+    std::vector<TypeId> arrayTypes;
+};
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_TYPETABLE_H
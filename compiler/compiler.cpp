@@ -4,33 +4,33 @@
 
 #include "./compiler.h"
 
-std::unordered_map<TokenType , std::string> tokenTypeToStringTypeMap = {
-        {INT_TYPE, "number"},
-        {STRING_TYPE, "string"},
-        {BOOL_TYPE, "boolean"},
-        {ARRAY_TYPE+INT_TYPE, "number"},
-        {BOOL_TYPE, "boolean"},
-        {BOOL_TYPE, "boolean"},
-        {NOTYPE_TYPE, "void"},
-};
-
-std::string getTsType(const TokenType& type, const std::unique_ptr<TypeNode>& nodeType) {
-    if (type.find(ARRAY_TYPE) == 0) {
-        if (auto arrType = dynamic_cast<ArrayType*>(nodeType.get())) {
-            return tokenTypeToStringTypeMap[arrType->getSubType()] + "[]";
-        }
-        throw std::runtime_error("Failed to convert to TypeScript type.");
-    } else {
-        return tokenTypeToStringTypeMap[type];
+// TypeScript name of a builtin type. Nothing here is written to, so compilations on several threads can share it.
+static const char* tsTypeName(TokenType kind) {
+    switch (kind) {
+        case INT_TYPE:
+        case FLOAT_TYPE:
+            return "number";
+        case STRING_TYPE:
+            return "string";
+        case BOOL_TYPE:
+            return "boolean";
+        case NOTYPE_TYPE:
+            return "void";
+        default:
+            return "";
     }
 }
 
-std::string getTsSubType(const std::string& type) {
-    auto pos = type.find(ARRAY_TYPE);
+std::string getTsType(const TypeTable& types, TypeId type) {
+    if (types.isArray(type)) {
+        return getTsType(types, types.element(type)) + "[]";
+    }
+    return tsTypeName(types.kind(type));
+}
 
-    if (pos == 0) {
-        std::string subType = type.substr(ARRAY_TYPE.length());
-        return  tokenTypeToStringTypeMap[subType];
+std::string getTsElementType(const TypeTable& types, TypeId type) {
+    if (types.isArray(type)) {
+        return getTsType(types, types.element(type));
     } else {
         throw std::runtime_error("Type has no subtypes.");
     }
@@ -62,200 +62,283 @@ std::string Compiler::getIndent() {
     return ident;
 }
 
-void Compiler::compile(const std::unique_ptr<Node>& node) {
-    if (auto program = dynamic_cast<Program*>(node.get())) {
-        for (const auto& statement : program->nodes) {
-            compile(statement);
-        }
-    } else if (auto printNode = dynamic_cast<PrintNode*>(node.get())) {
-        emitPrintNode(printNode);
-    } else if (auto rvalue = dynamic_cast<RValue*>(node.get())) {
-        if (auto declStmt = dynamic_cast<Declaration*>(rvalue->value.get())) {
-            emitDeclaration(declStmt, false);
-        } else if (auto funcCall = dynamic_cast<FunctionCall*>(rvalue->value.get())) {
-            emitFunctionCall(funcCall);
-        } else {
-            throw std::runtime_error("Unhandled RValue type in compilation.");
-        }
-    } else if (auto declStmt = dynamic_cast<Declaration*>(node.get())) {
-        if (auto infix = dynamic_cast<Infix*>(declStmt->value.get())) {
-            emitInfix(infix, declStmt, true);
-            return ;
-        }
-        return declStmt->isConstant ? emitDeclaration(declStmt, true) : emitDeclaration(declStmt, false);
-    } else if (auto func = dynamic_cast<Function*>(node.get())) {
-        emitFunc(func);
-    } else if (auto returnStmt = dynamic_cast<ReturnNode*>(node.get())) {
-        emitReturn(returnStmt);
-    } else if (auto ifStmt = dynamic_cast<IfElseNode*>(node.get())) {
-        emitIfElse(ifStmt);
-    } else if (auto assignment = dynamic_cast<Assignment*>(node.get())) {
-        emitAssignment(assignment);
-    } else {
-        throw std::runtime_error("Unhandled node subType in compilation.");
+// Variables are looked up by symbol. An expression that is not a plain identifier only resolves if its text happens
+// to be a known name.
+SymbolId Compiler::symbolOf(NodeId node) const {
+    if (program->kind(node) == NODE_IDENTIFIER) {
+        return program->node(node).lhs;
+    }
+    return program->symbols->find(program->string(node));
+}
+
+// Names the compiler has not seen declared, such as functions defined later in the file, have no known type.
+const Variable& Compiler::resolve(SymbolId name) {
+    auto var = currentScope()->resolve(name);
+    if (!var) {
+        throw std::runtime_error("Undefined name: " + std::string(program->name(name)));
+    }
+    return *var;
+}
+
+void Compiler::compile(const Program& program) {
+    this->program = &program;
+    for (auto statement : program.statements) {
+        compileNode(statement);
+    }
+    this->program = nullptr;
+}
+
+void Compiler::compileStatement(const Program& program, NodeId statement) {
+    this->program = &program;
+    compileNode(statement);
+    this->program = nullptr;
+}
+
+void Compiler::compileNode(NodeId node) {
+    const auto& n = program->node(node);
+
+    switch (n.kind) {
+        case NODE_PRINT:
+            emitPrintNode(node);
+            break;
+        case NODE_RVALUE:
+            switch (program->kind(n.lhs)) {
+                case NODE_DECLARATION:
+                    compileNode(n.lhs);
+                    break;
+                case NODE_FUNCTION_CALL:
+                    emitFunctionCall(n.lhs);
+                    break;
+                default:
+                    throw std::runtime_error("Unhandled RValue type in compilation.");
+            }
+            break;
+        case NODE_DECLARATION:
+            if (program->kind(n.rhs) == NODE_INFIX) {
+                emitInfix(n.rhs, node);
+                return;
+            }
+            emitDeclaration(node, n.isConstant());
+            break;
+        case NODE_FUNCTION:
+            emitFunc(node);
+            break;
+        case NODE_RETURN:
+            emitReturn(node);
+            break;
+        case NODE_IF_ELSE:
+            emitIfElse(node);
+            break;
+        case NODE_ASSIGNMENT:
+            emitAssignment(node);
+            break;
+        default:
+            throw std::runtime_error("Unhandled node subType in compilation.");
     }
 }
 
-void Compiler::emitDeclaration(Declaration *node, bool isConstant) {
+void Compiler::emitDeclaration(NodeId node, bool isConstant) {
     if (!node) return;
     auto indent = getIndent();
     auto scope = currentScope();
     auto declKeyword = isConstant ? "const " : "let ";
+    const auto& decl = program->node(node);
+    const auto& value = program->node(decl.rhs);
+    auto name = program->string(decl.lhs);
     outputStream << indent;
 
-    if (auto funcCall = dynamic_cast<FunctionCall*>(node->value.get())) {
-        if (isConstant) throw std::runtime_error("Const value can't be a result of function call.");
-        auto type = scope->resolve(funcCall->funcName)->type;
-        auto tsType = tokenTypeToStringTypeMap[type];
-        outputStream << "let " << node->name->string() << ": " << tsType << " = ";
-        emitFunctionCall(funcCall);
-        outputStream << ";\n";
-        return;
-    }
-
-    if (auto index = dynamic_cast<Index*>(node->value.get())) {
-        if (isConstant) throw std::runtime_error("Const value can't be a result of function call.");
-        std::string type;
-        std::string tsType;
-
-        if (auto ident = dynamic_cast<Identifier*>(index->left.get())) {
-            type = ident->type ? ident->type->getType() : scope->resolve(ident->name)->type;
-            tsType = getTsSubType(type);
-        } else if (index->left->type->getType() != ARRAY_TYPE) throw std::runtime_error("Index can be only used with arrays");
-        outputStream << "let " << node->name->string() << ": " << tsType << " = " << index->string() << ";\n";
-        return;
+    switch (value.kind) {
+        case NODE_FUNCTION_CALL: {
+            if (isConstant) throw std::runtime_error("Const value can't be a result of function call.");
+            auto tsType = getTsType(program->types, resolve(value.lhs).type);
+            outputStream << "let " << name << ": " << tsType << " = ";
+            emitFunctionCall(decl.rhs);
+            outputStream << ";\n";
+            return;
+        }
+        case NODE_INDEX: {
+            if (isConstant) throw std::runtime_error("Const value can't be a result of function call.");
+            std::string tsType;
+            const auto& left = program->node(value.lhs);
+
+            if (left.kind == NODE_IDENTIFIER) {
+                if (left.type) {
+                    tsType = getTsElementType(program->types, left.type);
+                } else {
+                    tsType = getTsElementType(program->types, resolve(left.lhs).type);
+                }
+            } else if (!program->types.isArray(left.type)) throw std::runtime_error("Index can be only used with arrays");
+            outputStream << "let " << name << ": " << tsType << " = " << program->string(decl.rhs) << ";\n";
+            return;
+        }
+        default:
+            break;
     }
 
-    if (node->holdsMultipleValues) {
-        for (const auto & value : node->multipleValues) {
-            auto declStmt = dynamic_cast<Declaration*>(value.get());
-            emitDeclaration(declStmt, isConstant);
+    if (decl.holdsMultipleValues()) {
+        for (uint32_t i = 0; i < decl.list.count; i++) {
+            emitDeclaration(program->child(decl.list, i), isConstant);
         }
         return;
     }
 
-    if (node->type->getType() == INT_TYPE || node->type->getType() == BOOL_TYPE || node->type->getType() == STRING_TYPE) {
-        if (node->value->holdsValue) {
-            outputStream << declKeyword << node->name->string() << ": " << tokenTypeToStringTypeMap[node->type->getType()] << " = " << node->value->string() << ";\n";
-        } else {
-            outputStream << declKeyword << node->name->string() << ": " << tokenTypeToStringTypeMap[node->type->getType()] << ";\n";
+    switch (program->types.kind(decl.type)) {
+        case INT_TYPE:
+        case FLOAT_TYPE:
+        case BOOL_TYPE:
+        case STRING_TYPE: {
+            scope->define(symbolOf(decl.lhs), decl.type);
+            auto tsType = getTsType(program->types, decl.type);
+            if (value.holdsValue()) {
+                outputStream << declKeyword << name << ": " << tsType << " = " << program->string(decl.rhs) << ";\n";
+            } else {
+                outputStream << declKeyword << name << ": " << tsType << ";\n";
+            }
+            break;
         }
-    } else if (node->type->getType() == ARRAY_TYPE && !isConstant) {
-        std::string arrType = node->type->getSubType();
-        scope->define(node->name->string(), node->type->getType() + node->type->getSubType());
-        outputStream << "let " << node->name->string() <<": " << tokenTypeToStringTypeMap[arrType] << "[]";
-
-        if (node->value->holdsValue) {
-            outputStream << " = " << node->value->string();
-            outputStream << ";\n";
-        } else {
-            outputStream << ";\n";
+        case ARRAY_TYPE:
+            if (isConstant) break;
+            scope->define(symbolOf(decl.lhs), decl.type);
+            outputStream << "let " << name <<": " << getTsType(program->types, decl.type);
+
+            if (value.holdsValue()) {
+                outputStream << " = " << program->string(decl.rhs);
+                outputStream << ";\n";
+            } else {
+                outputStream << ";\n";
+            }
+            break;
+        case NOTYPE_TYPE: {
+            if (isConstant) break;
+            auto valueString = program->string(decl.rhs);
+            // A negation has the type of what it negates.
+            auto operand = decl.rhs;
+            while (program->kind(operand) == NODE_PREFIX) {
+                operand = program->node(operand).rhs;
+            }
+            auto symbol = symbolOf(operand);
+            if (!symbol) throw std::runtime_error("Cannot infer the type of " + name);
+            auto type = resolve(symbol).type;
+            scope->define(symbolOf(decl.lhs), type);
+            auto tsType = getTsType(program->types, type);
+            outputStream << "let " << name << ": " << tsType << " = " << valueString << ";\n";
+            break;
         }
-    } else if (node->type->getType() == NOTYPE_TYPE && !isConstant) {
-        auto type = scope->resolve(node->value->string())->type;
-        auto tsType = tokenTypeToStringTypeMap[type];
-        outputStream << "let " << node->name->string() << ": " << tsType << " = " << node->value->string() << ";\n";
+        default:
+            break;
     }
 }
 
-void Compiler::emitFunc(Function *node) {
+void Compiler::emitFunc(NodeId node) {
     if (!node) return;
     auto indent = getIndent();
     enterScope();
     std::string paramString;
 
     auto scope = currentScope();
+    const auto& func = program->node(node);
+    auto funcName = program->name(func.lhs);
 
-    for (int i = 0; i < node->parameters.size(); i++) {
+    for (uint32_t i = 0; i < func.list.count; i++) {
+        const auto& param = program->node(program->child(func.list, i));
+        auto paramName = std::string(program->name(param.lhs));
 
-        scope->define(node->parameters[i]->string(), node->parameters[i]->type->getType());
+        scope->define(param.lhs, param.type);
 
-        if (i < node->parameters.size()-1) {
-            paramString += node->parameters[i]->string() + ": " + getTsType(node->parameters[i]->type->getType(), node->parameters[i]->type) + ", ";
+        if (i < func.list.count - 1) {
+            paramString += paramName + ": " + getTsType(program->types, param.type) + ", ";
         } else {
-            paramString += node->parameters[i]->string() + ": " + getTsType(node->parameters[i]->type->getType(), node->parameters[i]->type);
+            paramString += paramName + ": " + getTsType(program->types, param.type);
         }
     }
 
-    outputStream << indent << "function " << node->funcName << "(" << paramString << ")";
+    outputStream << indent << "function " << funcName << "(" << paramString << ")";
 
-    if (node->type) {
-        scope->outer->define(node->funcName, node->type->getType());
-        outputStream << ": " << getTsType(node->type->getType(), node->type) << " ";
+    if (func.type) {
+        scope->outer->define(func.lhs, func.type);
+        outputStream << ": " << getTsType(program->types, func.type) << " ";
     } else {
-        scope->outer->define(node->funcName, NOTYPE_TYPE);
+        scope->outer->define(func.lhs, TYPE_VOID);
         outputStream << ": void ";
     }
 
     outputStream << "{" << "\n";
 
-    for (const auto &stmt : node->body->nodes) {
-        compile(stmt);
+    const auto& body = program->node(func.rhs).list;
+    for (uint32_t i = 0; i < body.count; i++) {
+        compileNode(program->child(body, i));
     }
 
     outputStream << indent << "}" << "\n";
     exitScope();
 }
 
-void Compiler::emitReturn(ReturnNode *node) {
+void Compiler::emitReturn(NodeId node) {
     if (!node) return;
-    if (node->value) {
-        outputStream << getIndent() << "return " << node->value->string() << ";" << "\n";
+    auto value = program->node(node).lhs;
+    if (value) {
+        outputStream << getIndent() << "return " << program->string(value) << ";" << "\n";
     } else {
         outputStream << getIndent() << "return;" << "\n";
     }
 }
 
-std::pair<std::string, std::string> Compiler::emitInfix(Infix *node, Declaration *decl, bool isRootCall) {
-    if (!node) return {"", ""};
+// The declared type of an infix expression is that of its leftmost operand. The left spine is walked rather than
+// recursed down, and the expression is rendered once, so long chains take linear time.
+void Compiler::emitInfix(NodeId node, NodeId decl) {
+    if (!node) return;
 
-    auto scope = currentScope();
-    std::string exprType;
-    std::string expr;
-
-    if (auto ident = dynamic_cast<Identifier*>(node->left.get())) {
-        exprType = scope->resolve(ident->name)->type;
-        expr = ident->string();
-    } else if (auto infix = dynamic_cast<Infix*>(node->left.get())) {
-        auto result = emitInfix(infix, decl, false);
-        expr = result.first;
-        exprType = result.second;
-    } else if (auto funcCall = dynamic_cast<FunctionCall*>(node->left.get())) {
-        if (decl->isConstant) throw std::runtime_error("Const value can't be a result of function call.");
-        exprType = scope->resolve(funcCall->funcName)->type;
-        expr = funcCall->string();
-    } else if (auto index = dynamic_cast<Index*>(node->left.get())) {
-        if (decl->isConstant) throw std::runtime_error("Const value can't be a result of index subscription");
-        exprType = index->type ? index->type->getType() : scope->resolve(index->left->string())->type;
-        expr = index->string();
-    } else if (auto valNode = dynamic_cast<ValueNode*>(node->left.get())) {
-        expr = valNode->string();
-        exprType = valNode->type->getType();
+    TypeId exprType = TYPE_VOID;
+    bool isConstant = program->node(decl).isConstant();
+    auto operand = node;
+    while (program->kind(operand) == NODE_INFIX) {
+        operand = program->node(operand).lhs;
     }
-
-    expr += " " + node->Operator + " " + node->right->string();
-
-    if (isRootCall) {
-        outputStream << getIndent() << "let " << decl->name->string() << ": " << tokenTypeToStringTypeMap[exprType] << " = " << expr << ";\n";
+    const auto& left = program->node(operand);
+
+    switch (left.kind) {
+        case NODE_IDENTIFIER:
+            exprType = resolve(left.lhs).type;
+            break;
+        case NODE_FUNCTION_CALL:
+            if (isConstant) throw std::runtime_error("Const value can't be a result of function call.");
+            exprType = resolve(left.lhs).type;
+            break;
+        case NODE_INDEX:
+            if (isConstant) throw std::runtime_error("Const value can't be a result of index subscription");
+            exprType = left.type ? left.type : program->types.element(resolve(symbolOf(left.lhs)).type);
+            break;
+        case NODE_INTEGER:
+        case NODE_FLOAT:
+        case NODE_STRING:
+        case NODE_BOOLEAN:
+        case NODE_ARRAY:
+            exprType = left.type;
+            break;
+        default:
+            break;
     }
 
-    return {expr, exprType};
+    outputStream << getIndent() << "let " << program->string(program->node(decl).lhs) << ": " << getTsType(program->types, exprType) << " = " << program->string(node) << ";\n";
 }
 
-void Compiler::emitIfElse(IfElseNode *node) {
-    outputStream << getIndent() << "if (" << node->condition->string() << ") {\n";
+void Compiler::emitIfElse(NodeId node) {
+    const auto& ifElse = program->node(node);
+    outputStream << getIndent() << "if (" << program->string(ifElse.lhs) << ") {\n";
     enterScope();
-    for (const auto &stmt : node->consequence->nodes) {
-        compile(stmt);
+    const auto& consequence = program->node(ifElse.rhs).list;
+    for (uint32_t i = 0; i < consequence.count; i++) {
+        compileNode(program->child(consequence, i));
     }
     exitScope();
     outputStream << getIndent() << "}";
 
-    if (node->alternative) {
+    if (ifElse.extra) {
         outputStream << " else {\n";
         enterScope();
-        for (const auto &stmt : node->alternative->nodes) {
-            compile(stmt);
+        const auto& alternative = program->node(ifElse.extra).list;
+        for (uint32_t i = 0; i < alternative.count; i++) {
+            compileNode(program->child(alternative, i));
         }
         exitScope();
         outputStream << getIndent() << "}";
@@ -263,20 +346,18 @@ void Compiler::emitIfElse(IfElseNode *node) {
     outputStream << "\n";
 }
 
-void Compiler::emitPrintNode(PrintNode *node) {
+void Compiler::emitPrintNode(NodeId node) {
     if (!node) return;
     outputStream << getIndent() << "console.log(";
 
-    for (int i=0; i<node->values.size(); i++) {
-        if (i < node->values.size()-1) {
-            outputStream << node->values[i]->string() << ", ";
+    const auto& values = program->node(node).list;
+    for (uint32_t i = 0; i < values.count; i++) {
+        if (i < values.count - 1) {
+            outputStream << program->string(program->child(values, i)) << ", ";
         } else {
-            outputStream << node->values[i]->string();
+            outputStream << program->string(program->child(values, i));
         }
     }
 
     outputStream << ");\n";
 }
-
-
-
@@ -9,28 +9,37 @@
 #include "../ast/ast.h"
 #include "varTable.h"
 
-extern std::unordered_map<TokenType , std::string> tokenTypeToStringTypeMap;
-std::string getTsType(const TokenType& type, const std::unique_ptr<TypeNode>& nodeType);
-std::string getTsSubType(const std::string& type);
+std::string getTsType(const TypeTable& types, TypeId type);
+std::string getTsElementType(const TypeTable& types, TypeId type);
 
+// All state of a compilation lives in the Compiler, so separate instances can run on separate threads.
 class Compiler {
 public:
-    Compiler(const std::string& outputFile) : outputStream(outputFile, std::ios::app) {
-        if (!outputStream.is_open()) {
+    Compiler(const std::string& outputFile) : outputFile(outputFile, std::ios::app), outputStream(this->outputFile) {
+        if (!this->outputFile.is_open()) {
             throw std::runtime_error("Failed to open output file: " + outputFile);
         }
         enterScope();
     }
+    // Writes to a stream the caller owns, e.g. one in memory.
+    explicit Compiler(std::ostream& output) : outputStream(output) {
+        enterScope();
+    }
     ~Compiler() {
-        if (outputStream.is_open()) {
-            outputStream.close();
+        if (outputFile.is_open()) {
+            outputFile.close();
         }
     }
-    void compile(const std::unique_ptr<Node>& node);
+    void compile(const Program& program);
+    // Emits one top-level statement. Globals it declares stay defined for the statements compiled after it, which
+    // may come from a different Program as long as it shares the types and symbols.
+    void compileStatement(const Program& program, NodeId statement);
 private:
+    const Program* program = nullptr;
     int indentLevel = -1;
     std::unique_ptr<VarTable> varTable;
-    std::ofstream outputStream;
+    std::ofstream outputFile;
+    std::ostream& outputStream;
     std::vector<std::unique_ptr<VarTable>> scopeStack{};
 
     // Scope management
@@ -39,15 +48,18 @@ private:
     VarTable* currentScope();
 
     std::string getIndent();
+    SymbolId symbolOf(NodeId node) const;
+    const Variable& resolve(SymbolId name);
 
-    void emitDeclaration(Declaration* node, bool isConstant);
-    void emitFunc(Function* node);
-    void emitReturn(ReturnNode* node);
-    inline void emitFunctionCall(FunctionCall* node) {if (!node) return; outputStream << node->string();}
-    std::pair<std::string, std::string> emitInfix(Infix *node, Declaration *decl, bool isRootCall);
-    void emitIfElse(IfElseNode *node);
-    inline void emitAssignment(Assignment *node) {if (!node) return; outputStream << getIndent() << node->string() << ";\n";}
-    void emitPrintNode(PrintNode *node);
+    void compileNode(NodeId node);
+    void emitDeclaration(NodeId node, bool isConstant);
+    void emitFunc(NodeId node);
+    void emitReturn(NodeId node);
+    inline void emitFunctionCall(NodeId node) {if (!node) return; outputStream << program->string(node);}
+    void emitInfix(NodeId node, NodeId decl);
+    void emitIfElse(NodeId node);
+    inline void emitAssignment(NodeId node) {if (!node) return; outputStream << getIndent() << program->string(node) << ";\n";}
+    void emitPrintNode(NodeId node);
 };
 
 #endif //GO_TO_TS_SIMPLE_COMPILER_COMPILER_H
@@ -4,15 +4,15 @@
 
 #include "varTable.h"
 
-void VarTable::define(std::string name, TokenType type) {
+void VarTable::define(SymbolId name, TypeId type) {
     VarScope scope = outer == nullptr ? GLOBAL_SCOPE : LOCAL_SCOPE;
-    varMap.emplace(name, std::make_unique<Variable>(name, type, scope));
+    varMap.emplace(name, Variable(name, type, scope));
 }
 
-std::unique_ptr<Variable> VarTable::resolve(const std::string& name) {
+const Variable* VarTable::resolve(SymbolId name) const {
     auto it = varMap.find(name);
     if (it != varMap.end()) {
-        return std::make_unique<Variable>(*it->second);
+        return &it->second;
     } else if (outer != nullptr) {
         return outer->resolve(name);
     }
@@ -9,7 +9,9 @@
 #include <memory>
 #include <vector>
 #include <algorithm>
-#include "../token/token.h"
+#include <unordered_map>
+#include "../ast/typeTable.h"
+#include "../token/symbolTable.h"
 
 using VarScope = std::string;
 
@@ -17,22 +19,24 @@ const VarScope GLOBAL_SCOPE = "GLOBAL";
 const VarScope LOCAL_SCOPE = "LOCAL";
 
 struct Variable {
-    std::string name;
+    SymbolId name;
     VarScope scope;
-    TokenType type;
+    TypeId type;
 
-    Variable(std::string name, TokenType type, const VarScope &scope) : name(name), type(type), scope(scope) {};
+    Variable(SymbolId name, TypeId type, const VarScope &scope) : name(name), type(type), scope(scope) {};
 };
 
+// Variables are keyed by symbol id, so defining and resolving a name never copies or hashes its text.
 class VarTable {
 public:
     std::unique_ptr<VarTable> outer;
-    std::unordered_map<std::string, std::unique_ptr<Variable>> varMap{};
+    std::unordered_map<SymbolId, Variable> varMap{};
 
     VarTable() {};
 
-    void define(std::string name, TokenType type);
-    std::unique_ptr<Variable> resolve(const std::string& name);
+    void define(SymbolId name, TypeId type);
+    // Searches this scope and then the enclosing ones; returns nullptr if the name is not defined.
+    const Variable* resolve(SymbolId name) const;
 };
 
 #endif //GO_TO_TS_SIMPLE_COMPILER_VARTABLE_H
@@ -0,0 +1,38 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_BYTESOURCE_H
+#define GO_TO_TS_SIMPLE_COMPILER_BYTESOURCE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Pull-based input for the streaming Lexer.
+class ByteSource {
+public:
+    virtual ~ByteSource() = default;
+    // Reads up to `capacity` bytes into `buffer`. Returns 0 only once the input is exhausted.
+    virtual size_t read(char* buffer, size_t capacity) = 0;
+};
+
+class FdSource : public ByteSource {
+public:
+    explicit FdSource(int fd) : fd(fd) {}
+    size_t read(char* buffer, size_t capacity) override;
+private:
+    int fd;
+};
+
+// Read-only memory mapping of a whole file, handed to the Lexer as a view without copying it.
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline std::string_view contents() const { return {data, length}; }
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+};
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_BYTESOURCE_H
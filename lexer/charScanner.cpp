@@ -0,0 +1,135 @@
+#include "charScanner.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GO_TO_TS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+template <CharClass Class>
+static size_t scanScalar(const char* data, size_t length) {
+    size_t i = 0;
+    while (i < length && hasCharClass(data[i], Class)) {
+        i++;
+    }
+    return i;
+}
+
+#ifdef GO_TO_TS_X86_SIMD
+
+// Bytes >= 0x80 compare as negative, so the signed range checks below never accept them.
+template <CharClass Class>
+static inline unsigned classMaskSse2(__m128i v) {
+    __m128i hit;
+    if constexpr (Class == CHAR_WHITESPACE) {
+        hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                           _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    } else if constexpr (Class == CHAR_LETTER) {
+        __m128i folded = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(folded, _mm_set1_epi8('a' - 1)),
+                                      _mm_cmplt_epi8(folded, _mm_set1_epi8('z' + 1)));
+        hit = _mm_or_si128(alpha, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('_')), _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))));
+    } else if constexpr (Class == CHAR_DIGIT) {
+        hit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    } else if constexpr (Class == CHAR_STRING_BODY) {
+        __m128i stop = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_setzero_si128())));
+        hit = _mm_xor_si128(stop, _mm_set1_epi8(-1));
+    } else {
+        __m128i stop = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('`')), _mm_cmpeq_epi8(v, _mm_setzero_si128()));
+        hit = _mm_xor_si128(stop, _mm_set1_epi8(-1));
+    }
+    return static_cast<unsigned>(_mm_movemask_epi8(hit));
+}
+
+template <CharClass Class>
+static size_t scanSse2(const char* data, size_t length) {
+    size_t i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        unsigned miss = ~classMaskSse2<Class>(v) & 0xFFFFu;
+        if (miss) {
+            return i + __builtin_ctz(miss);
+        }
+    }
+    return i + scanScalar<Class>(data + i, length - i);
+}
+
+template <CharClass Class>
+__attribute__((target("avx2"))) static inline unsigned classMaskAvx2(__m256i v) {
+    __m256i hit;
+    if constexpr (Class == CHAR_WHITESPACE) {
+        hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                              _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\r'))));
+    } else if constexpr (Class == CHAR_LETTER) {
+        __m256i folded = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(folded, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), folded));
+        hit = _mm256_or_si256(alpha, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))));
+    } else if constexpr (Class == CHAR_DIGIT) {
+        hit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+    } else if constexpr (Class == CHAR_STRING_BODY) {
+        __m256i stop = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))),
+                                       _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256())));
+        hit = _mm256_xor_si256(stop, _mm256_set1_epi8(-1));
+    } else {
+        __m256i stop = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('`')), _mm256_cmpeq_epi8(v, _mm256_setzero_si256()));
+        hit = _mm256_xor_si256(stop, _mm256_set1_epi8(-1));
+    }
+    return static_cast<unsigned>(_mm256_movemask_epi8(hit));
+}
+
+template <CharClass Class>
+__attribute__((target("avx2"))) static size_t scanAvx2(const char* data, size_t length) {
+    size_t i = 0;
+    for (; i + 32 <= length; i += 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        unsigned miss = ~classMaskAvx2<Class>(v);
+        if (miss) {
+            return i + __builtin_ctz(miss);
+        }
+    }
+    return i + scanSse2<Class>(data + i, length - i);
+}
+
+#endif
+
+using ScanFn = size_t (*)(const char*, size_t);
+
+struct ScanKernels {
+    const char* name;
+    ScanFn whitespace;
+    ScanFn letters;
+    ScanFn digits;
+    ScanFn stringBody;
+    ScanFn rawStringBody;
+};
+
+#define SCAN_KERNELS(name, impl) \
+    ScanKernels{name, impl<CHAR_WHITESPACE>, impl<CHAR_LETTER>, impl<CHAR_DIGIT>, impl<CHAR_STRING_BODY>, \
+                impl<CHAR_RAW_STRING_BODY>}
+
+static ScanKernels selectKernels() {
+#ifdef GO_TO_TS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SCAN_KERNELS("avx2", scanAvx2);
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SCAN_KERNELS("sse2", scanSse2);
+    }
+#endif
+    return SCAN_KERNELS("scalar", scanScalar);
+}
+
+static const ScanKernels& kernels() {
+    static const ScanKernels selected = selectKernels();
+    return selected;
+}
+
+size_t scanWhitespace(const char* data, size_t length) { return kernels().whitespace(data, length); }
+size_t scanLetters(const char* data, size_t length) { return kernels().letters(data, length); }
+size_t scanDigits(const char* data, size_t length) { return kernels().digits(data, length); }
+size_t scanStringBody(const char* data, size_t length) { return kernels().stringBody(data, length); }
+size_t scanRawStringBody(const char* data, size_t length) { return kernels().rawStringBody(data, length); }
+
+const char* activeScanKernel() { return kernels().name; }
@@ -0,0 +1,45 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_CHARSCANNER_H
+#define GO_TO_TS_SIMPLE_COMPILER_CHARSCANNER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum CharClass : uint8_t {
+    CHAR_LETTER = 1 << 0,
+    CHAR_DIGIT = 1 << 1,
+    CHAR_WHITESPACE = 1 << 2,
+    CHAR_STRING_BODY = 1 << 3,
+    CHAR_RAW_STRING_BODY = 1 << 4,
+};
+
+constexpr std::array<uint8_t, 256> makeCharClassTable() {
+    std::array<uint8_t, 256> table{};
+    for (int c = 0; c < 256; c++) {
+        uint8_t cls = 0;
+        if (('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z') || c == '_' || c == '.') cls |= CHAR_LETTER;
+        if ('0' <= c && c <= '9') cls |= CHAR_DIGIT;
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') cls |= CHAR_WHITESPACE;
+        if (c != '"' && c != '\\' && c != '\n' && c != '\0') cls |= CHAR_STRING_BODY;
+        if (c != '`' && c != '\0') cls |= CHAR_RAW_STRING_BODY;
+        table[c] = cls;
+    }
+    return table;
+}
+
+inline constexpr std::array<uint8_t, 256> charClassTable = makeCharClassTable();
+
+inline bool hasCharClass(char ch, CharClass cls) { return charClassTable[static_cast<unsigned char>(ch)] & cls; }
+
+// Each scanner returns the length of the longest prefix of [data, data + length) whose bytes all belong to
+// the class. The SSE2/AVX2/scalar implementation is picked once, at first use, from the running CPU.
+size_t scanWhitespace(const char* data, size_t length);
+size_t scanLetters(const char* data, size_t length);
+size_t scanDigits(const char* data, size_t length);
+// String bodies stop at anything the lexer has to look at: the closing quote, a backslash, a newline or NUL.
+size_t scanStringBody(const char* data, size_t length);
+size_t scanRawStringBody(const char* data, size_t length);
+
+const char* activeScanKernel();
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_CHARSCANNER_H
@@ -3,10 +3,22 @@
 //
 
 #include "lexer.h"
+#include "utf8.h"
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 
+Lexer::Lexer(ByteSource* stream, size_t windowSize, uint64_t baseOffset)
+    : stream(stream), windowOffset(baseOffset), windowSize(std::max<size_t>(windowSize, 16)) {
+    readChar();
+}
+
 void Lexer::readChar() {
+    if (nextPosition >= input.length() && stream) {
+        ensureAvailable(0);
+    }
+
     if (nextPosition >= input.length()) {
         ch = '\0';
     } else {
@@ -17,175 +29,370 @@ void Lexer::readChar() {
     nextPosition++;
 }
 
-Token newToken(const TokenType& tokenType, char ch) {
-    return Token{tokenType, ch};
+// Makes sure `count` bytes past nextPosition are buffered, unless the stream ends first.
+void Lexer::ensureAvailable(size_t count) {
+    while (stream && !streamExhausted && nextPosition + count >= input.length()) {
+        refill();
+    }
 }
 
-Token newToken(const TokenType& tokenType, std::string ch) {
-    return Token{tokenType, std::move(ch)};
+// Moves the bytes from tokenStart on to the front of a window and reads more input after them. A new window is
+// used unless the pending token already starts the current one, so the windows holding the last two tokens'
+// literals are never overwritten.
+void Lexer::refill() {
+    size_t keepFrom = std::min(tokenStart, input.length());
+    size_t kept = input.length() - keepFrom;
+    int target = activeWindow;
+
+    if (keepFrom > 0 || input.empty()) {
+        for (int i = 0; i < static_cast<int>(windows.size()); i++) {
+            if (i != activeWindow && i != currentTokenWindow && i != previousTokenWindow) {
+                target = i;
+                break;
+            }
+        }
+    }
+
+    auto& window = windows[target];
+    size_t capacity = std::max(window.length(), windowSize);
+    if (kept * 2 > capacity) {
+        capacity = kept * 2;
+    }
+    window.resize(capacity);
+    if (target != activeWindow && kept > 0) {
+        std::memcpy(window.data(), input.data() + keepFrom, kept);
+    }
+
+    auto read = stream->read(window.data() + kept, capacity - kept);
+    if (read == 0) {
+        streamExhausted = true;
+    }
+
+    activeWindow = target;
+    input = std::string_view(window.data(), kept + read);
+    windowOffset += keepFrom;
+    position -= std::min(position, keepFrom);
+    nextPosition -= keepFrom;
+    tokenStart -= keepFrom;
 }
 
-std::string Lexer::readIdentifierOrType() {
-    auto startPosition = position;
-    while (isLetter(ch)) {
-        readChar();
+// Moves past `count` bytes at once; equivalent to calling readChar() `count` times.
+void Lexer::advance(size_t count) {
+    nextPosition = position + count;
+    readChar();
+}
+
+Token Lexer::makeToken(TokenType tokenType, size_t start, size_t length) {
+    currentTokenWindow = activeWindow;
+    Token token{tokenType, slice(start, length), windowOffset + start};
+    token.StartsLine = lineBreak;
+    return token;
+}
+
+// The scanners stop at the end of the buffered input, so in streaming mode each run is resumed after a refill.
+size_t Lexer::readIdentifierOrType() {
+    while (true) {
+        advance(scanLetters(remaining(), remainingLength()));
+        if (isLetter(ch)) {
+            continue;
+        }
+        auto length = unicodeLetterLength(true);
+        if (length == 0) {
+            break;
+        }
+        advance(length);
     }
 
-    return input.substr(startPosition, position - startPosition);
+    return position - tokenStart;
+}
+
+// Length of the UTF-8 encoded letter, or with `digits` set letter or decimal digit, at `position`, or 0 if there is
+// none. Only non-ASCII bytes are decoded; the bulk scan has already dealt with everything else.
+size_t Lexer::unicodeLetterLength(bool digits) {
+    if (static_cast<unsigned char>(ch) < 0x80) {
+        return 0;
+    }
+    ensureAvailable(3);
+    char32_t codePoint;
+    auto length = decodeUtf8(remaining(), remainingLength(), codePoint);
+    return length > 0 && (isUnicodeLetter(codePoint) || (digits && isUnicodeDigit(codePoint))) ? length : 0;
 }
 
-std::string Lexer::readNumber() {
-    auto startPosition = position;
-    while (isDigit(ch)) {
+// Reads Go integer and float literals: 0x/0o/0b prefixes, `_` separators, fractions and exponents. Separator
+// placement and digit ranges are checked when the parser converts the literal, so this only finds where it ends.
+size_t Lexer::readNumber(bool& isFloat) {
+    isFloat = false;
+    bool hex = false;
+    bool fractionAllowed = true;
+
+    if (ch == '0') {
+        auto prefix = static_cast<char>(peekChar() | 0x20);
+        if (prefix == 'x' || prefix == 'o' || prefix == 'b') {
+            hex = prefix == 'x';
+            fractionAllowed = hex;
+            readChar();
+            readChar();
+        }
+    }
+
+    readDigits(hex);
+    if (fractionAllowed && ch == '.' && peekChar() != '.') {
+        isFloat = true;
         readChar();
+        readDigits(hex);
     }
 
-    return input.substr(startPosition, position - startPosition);
+    auto exponent = static_cast<char>(ch | 0x20);
+    if ((hex && exponent == 'p') || (!hex && fractionAllowed && exponent == 'e')) {
+        isFloat = true;
+        readChar();
+        if (ch == '+' || ch == '-') {
+            readChar();
+        }
+        readDigits(false);
+    }
+
+    return position - tokenStart;
 }
 
+void Lexer::readDigits(bool hex) {
+    while (true) {
+        if (isDigit(ch)) {
+            advance(scanDigits(remaining(), remainingLength()));
+        } else if (ch == '_' || (hex && isHexLetter(ch))) {
+            readChar();
+        } else {
+            break;
+        }
+    }
+}
+
+// Skips whitespace and comments. None of it has to survive a refill, so tokenStart is kept ahead of each run.
 void Lexer::skipWhitespace() {
-    while (ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r') {
-        readChar();
+    lineBreak = false;
+    while (true) {
+        if (hasCharClass(ch, CHAR_WHITESPACE)) {
+            auto count = scanWhitespace(remaining(), remainingLength());
+            lineBreak = lineBreak || std::memchr(remaining(), '\n', count);
+            tokenStart = position + count;
+            advance(count);
+        } else if (ch == '/' && peekChar() == '/') {
+            skipLineComment();
+        } else if (ch == '/' && peekChar() == '*') {
+            skipBlockComment();
+        } else {
+            break;
+        }
+    }
+    tokenStart = position;
+}
+
+// Stops on the newline that ends the comment, leaving it to the whitespace scan.
+void Lexer::skipLineComment() {
+    while (ch != '\n' && ch != '\0') {
+        auto rest = remainingLength();
+        auto newline = static_cast<const char*>(std::memchr(remaining(), '\n', rest));
+        auto count = newline ? static_cast<size_t>(newline - remaining()) : rest;
+        tokenStart = position + count;
+        advance(count);
+    }
+}
+
+// An unterminated block comment runs to the end of the input.
+void Lexer::skipBlockComment() {
+    tokenStart = position + 2;
+    advance(2);
+    while (ch != '\0') {
+        if (ch == '*' && peekChar() == '/') {
+            tokenStart = position + 2;
+            advance(2);
+            return;
+        }
+        auto rest = remainingLength();
+        auto star = rest > 1 ? static_cast<const char*>(std::memchr(remaining() + 1, '*', rest - 1)) : nullptr;
+        auto count = star ? static_cast<size_t>(star - remaining()) : rest;
+        lineBreak = lineBreak || std::memchr(remaining(), '\n', count);
+        tokenStart = position + count;
+        advance(count);
     }
 }
 
 char Lexer::peekChar() {
+    ensureAvailable(1);
     if (nextPosition >= input.length()) {
-        return '0';
+        return '\0';
     } else {
         return input[nextPosition];
     }
 }
 
-std::string Lexer::peekTwo() {
-    if (nextPosition >= input.length() && nextPosition + 1 >= input.length()) {
+std::string_view Lexer::peekTwo() {
+    ensureAvailable(2);
+    if (nextPosition + 1 >= input.length()) {
         return "";
     } else {
-        return std::string(1, input[nextPosition]) + std::string(1, input[nextPosition + 1]);
+        return slice(nextPosition, 2);
     }
 }
 
-std::string Lexer::readString() {
-    auto startPosition = position + 1 ;
+// Returns the length of the string body; the opening quote is at tokenStart. A backslash takes the next byte with it,
+// so an escaped quote does not end the literal. Escapes are left for the parser to decode. An unterminated literal
+// stops at the newline or the end of input, with ch on it.
+size_t Lexer::readString() {
+    readChar();
     while (true) {
-        readChar();
-        if (ch == '"' || ch == 0) {
+        advance(scanStringBody(remaining(), remainingLength()));
+        if (ch == '\\') {
+            readChar();
+            if (ch != '\n' && ch != '\0') {
+                readChar();
+            }
+        } else if (!hasCharClass(ch, CHAR_STRING_BODY)) {
             break;
         }
     }
 
-    return input.substr(startPosition, position-startPosition);
+    return position - tokenStart - 1;
+}
+
+// Raw strings run to the next backtick, newlines included.
+size_t Lexer::readRawString() {
+    readChar();
+    do {
+        advance(scanRawStringBody(remaining(), remainingLength()));
+    } while (hasCharClass(ch, CHAR_RAW_STRING_BODY));
+
+    return position - tokenStart - 1;
 }
 
 Token Lexer::nextToken() {
     Token tok{};
 
+    previousTokenWindow = currentTokenWindow;
+    tokenStart = position;
     skipWhitespace();
 
     switch (ch) {
         case '=':
             if (peekChar() == '=') {
-                auto prevCh = ch;
+                tok = newToken(EQ, 2);
                 readChar();
-                std::string literal = std::string{prevCh} + std::string{ch};
-                tok = Token{EQ, literal};
             } else {
-                tok = newToken(ASSIGN, ch);
+                tok = newToken(ASSIGN);
             }
             break;
         case '+':
-            tok = newToken(PLUS, ch);
+            tok = newToken(PLUS);
             break;
         case '-':
-            tok = newToken(MINUS, ch);
+            tok = newToken(MINUS);
             break;
         case '!':
             if (peekChar() == '=') {
-                auto prevCh = ch;
+                tok = newToken(NOT_EQ, 2);
                 readChar();
-                std::string literal = std::string{prevCh} + std::string{ch};
-                tok = Token{NOT_EQ, literal};
             } else {
-                tok = newToken(BANG, ch);
+                tok = newToken(BANG);
             }
             break;
         case '/':
-            tok = newToken(SLASH, ch);
+            tok = newToken(SLASH);
             break;
         case '.':
+            if (isDigit(peekChar())) {
+                bool isFloat;
+                auto length = readNumber(isFloat);
+                return makeToken(FLOAT, tokenStart, length);
+            }
             if (peekTwo() == "..") {
-                tok = newToken(VARIADIC, "...");
+                tok = newToken(VARIADIC, 3);
                 readChar();
                 readChar();
                 break;
             }
         case '*':
-            tok = newToken(ASTERISK, ch);
+            tok = newToken(ASTERISK);
             break;
         case '<':
-            tok = newToken(LESS_THAN, ch);
+            tok = newToken(LESS_THAN);
             break;
         case '>':
-            tok = newToken(GREATER_THAN, ch);
+            tok = newToken(GREATER_THAN);
             break;
         case '(':
-            tok = newToken(LPAREN, ch);
+            tok = newToken(LPAREN);
             break;
         case ')':
-            tok = newToken(RPAREN, ch);
+            tok = newToken(RPAREN);
             break;
         case ',':
-            tok = newToken(COMMA, ch);
+            tok = newToken(COMMA);
             break;
         case '{':
-            tok = newToken(LBRACE, ch);
+            tok = newToken(LBRACE);
             break;
         case '}':
-            tok = newToken(RBRACE, ch);
+            tok = newToken(RBRACE);
             break;
-        case '"':
-            tok.Type = STRING;
-            tok.Literal = readString();
+        case '"': {
+            auto length = readString();
+            tok = ch == '"' ? makeToken(STRING, tokenStart + 1, length) : makeToken(ILLEGAL, tokenStart, length + 1);
             break;
+        }
+        case '`': {
+            auto length = readRawString();
+            tok = ch == '`' ? makeToken(RAW_STRING, tokenStart + 1, length) : makeToken(ILLEGAL, tokenStart, length + 1);
+            break;
+        }
         case '[':
-            tok = newToken(LBRACKET, ch);
+            tok = newToken(LBRACKET);
             break;
         case ']':
-            tok = newToken(RBRACKET, ch);
+            tok = newToken(RBRACKET);
             break;
         case ':':
             if (peekChar() == '=') {
-                auto prevCh = ch;
+                tok = newToken(DECLARE, 2);
                 readChar();
-                std::string literal = std::string{prevCh} + std::string{ch};
-                tok = Token{DECLARE, literal};
             } else {
-                tok = newToken(COLON,  ch);
+                tok = newToken(COLON);
             }
             break;
         case '\0':
-            tok.Literal = "";
-            tok.Type = END_OF_FILE;
-            break;
+            // Not stepped over, so a NUL byte ends the input for good and every later call returns the same token,
+            // as TokenBuffer and TokenPipe do once they reach it.
+            return makeToken(END_OF_FILE, std::min(position, input.length()), 0);
         default:
-            if (isLetter(ch)) {
-                tok.Literal = readIdentifierOrType();
-                if (LookupType(tok.Literal) != NOTYPE_TYPE) {
-                    tok.Type = LookupType(tok.Literal);
-                    return tok;
-                }
+            if (isLetter(ch) || unicodeLetterLength() > 0) {
+                auto length = readIdentifierOrType();
+                tok = makeToken(IDENTIFIER, tokenStart, length);
                 tok.Type = LookupIdent(tok.Literal);
+                if (tok.Type == IDENTIFIER) {
+                    tok.Symbol = symbols->intern(tok.Literal);
+                }
                 return tok;
             } else if (isDigit(ch)) {
-                tok.Type = INT;
-                tok.Literal = readNumber();
-                return tok;
+                bool isFloat;
+                auto length = readNumber(isFloat);
+                return makeToken(isFloat ? FLOAT : INT, tokenStart, length);
             } else {
-                tok = newToken(ILLEGAL, ch);
+                // A whole character, so that a diagnostic shows it rather than its first byte.
+                size_t length = 1;
+                if (static_cast<unsigned char>(ch) >= 0x80) {
+                    ensureAvailable(3);
+                    char32_t codePoint;
+                    length = std::max<size_t>(decodeUtf8(remaining(), remainingLength(), codePoint), 1);
+                }
+                tok = newToken(ILLEGAL, length);
+                for (size_t i = 1; i < length; i++) {
+                    readChar();
+                }
                 break;
             }
     }
 
+    // The token is complete, so a refill triggered by stepping past it need not keep any of it.
+    tokenStart = nextPosition;
     readChar();
     return tok;
 }
\ No newline at end of file
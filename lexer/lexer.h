@@ -6,33 +6,85 @@
 #define GO_TO_TS_SIMPLE_COMPILER_LEXER_H
 
 
+#include <array>
+#include <memory>
 #include <string>
 #include <utility>
 #include "../token/token.h"
+#include "byteSource.h"
+#include "charScanner.h"
 
 class Lexer {
 public:
-    explicit Lexer(std::string input) : input(std::move(input)) {
+    static constexpr size_t defaultWindowSize = 1 << 16;
+
+    explicit Lexer(std::string source) : storage(std::move(source)), input(storage) {
+        readChar();
+    }
+    // Lexes a view it does not own, e.g. one chunk of a larger buffer; the view must outlive the tokens.
+    // `baseOffset` is where the view starts in the full source and is added to every Token::Offset.
+    explicit Lexer(std::string_view source, uint64_t baseOffset = 0) : input(source), windowOffset(baseOffset) {
         readChar();
     }
+    // Streams the input through a few fixed-size windows, so memory stays constant whatever the input size
+    // (a window only grows to fit a single token longer than it). A token's literal stays valid until two more
+    // tokens have been read, which is all the lookahead Parser needs. `baseOffset` is added to every Token::Offset.
+    explicit Lexer(ByteSource* stream, size_t windowSize = defaultWindowSize, uint64_t baseOffset = 0);
+    Lexer(const Lexer&) = delete;
+    Lexer& operator=(const Lexer&) = delete;
+
     Token nextToken();
+    inline std::string_view source() const { return input; }
+    inline bool isStreaming() const { return stream != nullptr; }
+    // Identifier tokens carry ids into this table. Later phases keep it alive by sharing it.
+    inline const std::shared_ptr<SymbolTable>& symbolTable() const { return symbols; }
+    // Interns identifiers into `table` instead of a table of its own; call before the first token is read.
+    inline void shareSymbolTable(std::shared_ptr<SymbolTable> table) { symbols = std::move(table); }
 private:
-    std::string input;
-    int position{};
-    int nextPosition{};
+    std::string storage;
+    std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>();
+    std::string_view input;
+    size_t position{};
+    size_t nextPosition{};
+    size_t tokenStart{};
     char ch{};
+    // Whether the whitespace and comments skipped before the current token hold a newline.
+    bool lineBreak = false;
+
+    // Streaming state; input is a view of windows[activeWindow] and windowOffset its absolute start.
+    ByteSource* stream = nullptr;
+    bool streamExhausted = false;
+    uint64_t windowOffset = 0;
+    size_t windowSize = defaultWindowSize;
+    std::array<std::string, 3> windows{};
+    int activeWindow = 0;
+    int currentTokenWindow = 0;
+    int previousTokenWindow = 0;
 
     void readChar();
-    std::string readIdentifierOrType();
-    std::string readNumber();
+    void refill();
+    void ensureAvailable(size_t count);
+    void advance(size_t count);
+    inline const char* remaining() const { return input.data() + position; }
+    inline size_t remainingLength() const { return position < input.length() ? input.length() - position : 0; }
+    size_t readIdentifierOrType();
+    size_t unicodeLetterLength(bool digits = false);
+    size_t readNumber(bool& isFloat);
+    void readDigits(bool hex);
     void skipWhitespace();
+    void skipLineComment();
+    void skipBlockComment();
     char peekChar();
-    std::string peekTwo();
-    std::string readString();
+    std::string_view peekTwo();
+    size_t readString();
+    size_t readRawString();
+    inline std::string_view slice(size_t start, size_t length) const { return input.substr(start, length); }
+    Token makeToken(TokenType tokenType, size_t start, size_t length);
+    inline Token newToken(TokenType tokenType, size_t length = 1) { return makeToken(tokenType, position, length); }
 };
 
-Token newToken(const TokenType& tokenType, char ch);
-inline bool isLetter(char ch) { return 'a' <= ch && ch <= 'z' || 'A' <= ch && ch <= 'Z' || ch == '_' || ch == '.'; }
-inline bool isDigit(char ch) { return '0' <= ch && ch <= '9'; }
+inline bool isLetter(char ch) { return hasCharClass(ch, CHAR_LETTER); }
+inline bool isDigit(char ch) { return hasCharClass(ch, CHAR_DIGIT); }
+inline bool isHexLetter(char ch) { return (ch >= 'a' && ch <= 'f') || (ch >= 'A' && ch <= 'F'); }
 
 #endif //GO_TO_TS_SIMPLE_COMPILER_LEXER_H
@@ -0,0 +1,111 @@
+#include "numericLiteral.h"
+
+#include <charconv>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Large enough for any in-range integer with separators; longer literals with separators spill to the heap.
+constexpr size_t maxInlineLiteral = 128;
+
+bool isBaseDigit(char c, int base) {
+    if (c >= '0' && c <= '9') return c - '0' < base;
+    char lower = static_cast<char>(c | 0x20);
+    return base == 16 && lower >= 'a' && lower <= 'f';
+}
+
+// Splits off a base prefix. A lone leading zero followed by more digits is legacy octal.
+int detectBase(std::string_view literal, size_t& prefixLength) {
+    prefixLength = 0;
+    if (literal.length() < 2 || literal[0] != '0') return 10;
+    switch (literal[1] | 0x20) {
+        case 'x': prefixLength = 2; return 16;
+        case 'o': prefixLength = 2; return 8;
+        case 'b': prefixLength = 2; return 2;
+        default: prefixLength = 1; return 8;
+    }
+}
+
+[[noreturn]] void invalidLiteral(std::string_view literal) {
+    throw std::runtime_error("Invalid numeric literal: " + std::string(literal));
+}
+
+// Returns `digits` without its `_` separators, which must each sit between two digits of `base` (or right after a
+// base prefix). Literals without separators, the common case, are returned as they are.
+std::string_view stripSeparators(std::string_view literal, std::string_view digits, int base, bool afterPrefix,
+                                 char* buffer, std::string& spill) {
+    if (digits.find('_') == std::string_view::npos) {
+        return digits;
+    }
+
+    char* out = buffer;
+    if (digits.length() > maxInlineLiteral) {
+        spill.resize(digits.length());
+        out = spill.data();
+    }
+
+    size_t length = 0;
+    for (size_t i = 0; i < digits.length(); i++) {
+        if (digits[i] != '_') {
+            out[length++] = digits[i];
+            continue;
+        }
+        bool validBefore = i == 0 ? afterPrefix : isBaseDigit(digits[i - 1], base);
+        bool validAfter = i + 1 < digits.length() && isBaseDigit(digits[i + 1], base);
+        if (!validBefore || !validAfter) {
+            invalidLiteral(literal);
+        }
+    }
+    return {out, length};
+}
+
+}
+
+int64_t integerLiteralValue(std::string_view literal) {
+    size_t prefixLength;
+    int base = detectBase(literal, prefixLength);
+    char buffer[maxInlineLiteral];
+    std::string spill;
+    auto digits = stripSeparators(literal, literal.substr(prefixLength), base, prefixLength > 0, buffer, spill);
+
+    int64_t value = 0;
+    auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.length(), value, base);
+    if (error == std::errc::result_out_of_range) {
+        throw std::runtime_error("Integer literal out of range: " + std::string(literal));
+    }
+    if (digits.empty() || error != std::errc() || end != digits.data() + digits.length()) {
+        invalidLiteral(literal);
+    }
+    return value;
+}
+
+double floatLiteralValue(std::string_view literal) {
+    bool hex = literal.length() > 2 && literal[0] == '0' && (literal[1] | 0x20) == 'x';
+    size_t prefixLength = hex ? 2 : 0;
+    char buffer[maxInlineLiteral];
+    std::string spill;
+    auto digits = stripSeparators(literal, literal.substr(prefixLength), hex ? 16 : 10, hex, buffer, spill);
+    // Go requires the binary exponent of a hex float; from_chars would read 0x1.8 without one.
+    if (hex && digits.find_first_of("pP") == std::string_view::npos) {
+        throw std::runtime_error("Hexadecimal float literal needs a 'p' exponent: " + std::string(literal));
+    }
+
+    double value = 0;
+    auto format = hex ? std::chars_format::hex : std::chars_format::general;
+    auto [end, error] = std::from_chars(digits.data(), digits.data() + digits.length(), value, format);
+    if (error == std::errc::result_out_of_range) {
+        throw std::runtime_error("Float literal out of range: " + std::string(literal));
+    }
+    if (error != std::errc() || end != digits.data() + digits.length()) {
+        invalidLiteral(literal);
+    }
+    return value;
+}
+
+bool isExactAsDouble(int64_t value) {
+    auto magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+    if (magnitude <= (uint64_t(1) << 53)) return true;
+    // The bits from the highest set one down to the lowest must fit the 53-bit significand.
+    return 64 - __builtin_clzll(magnitude) - __builtin_ctzll(magnitude) <= 53;
+}
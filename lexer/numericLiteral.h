@@ -0,0 +1,14 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_NUMERICLITERAL_H
+#define GO_TO_TS_SIMPLE_COMPILER_NUMERICLITERAL_H
+
+#include <cstdint>
+#include <string_view>
+
+// Converts the text of an INT or FLOAT token straight from the source span. Both accept Go's 0x/0o/0b prefixes,
+// legacy leading-zero octal and `_` digit separators, and throw std::runtime_error on malformed or out of range literals.
+int64_t integerLiteralValue(std::string_view literal);
+double floatLiteralValue(std::string_view literal);
+// Whether a TypeScript number, a double, holds the integer exactly; all do up to 2^53, and only some beyond.
+bool isExactAsDouble(int64_t value);
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_NUMERICLITERAL_H
@@ -0,0 +1,105 @@
+#include "stringLiteral.h"
+#include "utf8.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+[[noreturn]] void invalidEscape(std::string_view body) {
+    throw std::runtime_error("Invalid escape sequence in string literal: \"" + std::string(body) + "\"");
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    char lower = static_cast<char>(c | 0x20);
+    if (lower >= 'a' && lower <= 'f') return lower - 'a' + 10;
+    return -1;
+}
+
+// Reads `count` digits of `base` at body[pos]; returns -1 if any is missing or out of range.
+long readEscapeDigits(std::string_view body, size_t pos, size_t count, int base) {
+    if (pos + count > body.length()) return -1;
+    long value = 0;
+    for (size_t i = 0; i < count; i++) {
+        int digit = hexValue(body[pos + i]);
+        if (digit < 0 || digit >= base) return -1;
+        value = value * base + digit;
+    }
+    return value;
+}
+
+}
+
+std::string decodeStringLiteral(std::string_view body) {
+    auto backslash = static_cast<const char*>(std::memchr(body.data(), '\\', body.length()));
+    if (!backslash) {
+        return std::string(body);
+    }
+
+    std::string out;
+    out.reserve(body.length());
+    size_t pos = 0;
+
+    while (pos < body.length()) {
+        auto next = body.find('\\', pos);
+        if (next == std::string_view::npos) {
+            out.append(body.substr(pos));
+            break;
+        }
+        out.append(body.substr(pos, next - pos));
+        pos = next + 1;
+        if (pos >= body.length()) invalidEscape(body);
+
+        char escape = body[pos++];
+        switch (escape) {
+            case 'a': out += '\a'; break;
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'v': out += '\v'; break;
+            case '\\': out += '\\'; break;
+            case '"': out += '"'; break;
+            case 'x': {
+                auto value = readEscapeDigits(body, pos, 2, 16);
+                if (value < 0) invalidEscape(body);
+                out += static_cast<char>(value);
+                pos += 2;
+                break;
+            }
+            case 'u':
+            case 'U': {
+                size_t count = escape == 'u' ? 4 : 8;
+                auto value = readEscapeDigits(body, pos, count, 16);
+                if (value < 0 || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF)) invalidEscape(body);
+                appendUtf8(out, static_cast<char32_t>(value));
+                pos += count;
+                break;
+            }
+            default: {
+                auto value = readEscapeDigits(body, pos - 1, 3, 8);
+                if (value < 0 || value > 0xFF) invalidEscape(body);
+                out += static_cast<char>(value);
+                pos += 2;
+                break;
+            }
+        }
+    }
+
+    return out;
+}
+
+std::string rawStringValue(std::string_view body) {
+    if (!std::memchr(body.data(), '\r', body.length())) {
+        return std::string(body);
+    }
+
+    std::string out;
+    out.reserve(body.length());
+    for (char c : body) {
+        if (c != '\r') out += c;
+    }
+    return out;
+}
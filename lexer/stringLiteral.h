@@ -0,0 +1,13 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_STRINGLITERAL_H
+#define GO_TO_TS_SIMPLE_COMPILER_STRINGLITERAL_H
+
+#include <string>
+#include <string_view>
+
+// Value of an interpreted string literal given its body (the text between the quotes). Bodies without a backslash
+// are copied as they are; escapes are decoded as in Go and an invalid one throws std::runtime_error.
+std::string decodeStringLiteral(std::string_view body);
+// Value of a raw string literal given the text between the backticks; carriage returns are dropped, as in Go.
+std::string rawStringValue(std::string_view body);
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_STRINGLITERAL_H
@@ -0,0 +1,270 @@
+#include "tokenBuffer.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+TokenBuffer::TokenBuffer(Lexer& lexer) : source(lexer.source()), symbols(lexer.symbolTable()) {
+    if (lexer.isStreaming()) {
+        throw std::runtime_error("A streaming lexer cannot fill a token buffer");
+    }
+    lexAll(lexer, true);
+}
+
+TokenBuffer::TokenBuffer(std::string_view source, unsigned threadCount, size_t minChunk) : source(source) {
+    size_t chunkCount = std::min<size_t>(std::max(threadCount, 1u), source.length() / std::max<size_t>(minChunk, 1));
+    // The Lexer treats a NUL byte as end of input, which a later chunk could not know about.
+    if (chunkCount <= 1 || source.find('\0') != std::string_view::npos) {
+        Lexer lexer(source);
+        symbols = lexer.symbolTable();
+        lexAll(lexer, true);
+        return;
+    }
+
+    auto boundaries = findChunkBoundaries(source, chunkCount);
+    std::vector<TokenBuffer> parts(boundaries.size() - 1, TokenBuffer(source));
+    std::vector<std::thread> workers;
+    workers.reserve(parts.size());
+
+    for (size_t i = 0; i < parts.size(); i++) {
+        workers.emplace_back([&, i]() {
+            bool last = i + 1 == parts.size();
+            Lexer lexer(source.substr(boundaries[i], boundaries[i + 1] - boundaries[i]), boundaries[i]);
+            parts[i].symbols = lexer.symbolTable();
+            parts[i].lexAll(lexer, last);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    size_t total = 0;
+    for (const auto& part : parts) {
+        total += part.size();
+    }
+    kinds.reserve(total);
+    offsets.reserve(total);
+    lengths.reserve(total);
+    tokenSymbols.reserve(total);
+    lineStarts.reserve(total);
+    // Each chunk interned its identifiers into its own table; renumber them into one shared table. There is one
+    // lookup per distinct name per chunk rather than per identifier.
+    symbols = std::make_shared<SymbolTable>();
+    std::vector<SymbolId> symbolMap;
+    for (size_t i = 0; i < parts.size(); i++) {
+        symbolMap.resize(parts[i].symbols->size());
+        for (SymbolId id = 0; id < symbolMap.size(); id++) {
+            symbolMap[id] = symbols->intern(parts[i].symbols->name(id));
+        }
+        append(parts[i], symbolMap, i > 0);
+    }
+}
+
+void TokenBuffer::lexAll(Lexer& lexer, bool keepEndOfFile) {
+    // Tokens average a handful of bytes; reserving up front avoids most regrowth on large inputs.
+    auto expected = lexer.source().length() / 4 + 1;
+    kinds.reserve(expected);
+    offsets.reserve(expected);
+    lengths.reserve(expected);
+    tokenSymbols.reserve(expected);
+    lineStarts.reserve(expected);
+
+    while (true) {
+        auto tok = lexer.nextToken();
+        if (tok.Type == END_OF_FILE && !keepEndOfFile) {
+            break;
+        }
+        kinds.push_back(tok.Type);
+        offsets.push_back(tok.Offset);
+        lengths.push_back(static_cast<uint32_t>(tok.Literal.length()));
+        tokenSymbols.push_back(tok.Symbol);
+        lineStarts.push_back(tok.StartsLine);
+        kindCounts[tok.Type]++;
+        if (tok.Type == END_OF_FILE) {
+            break;
+        }
+    }
+}
+
+// Every chunk but the first starts right after a newline, which its own Lexer never saw.
+void TokenBuffer::append(const TokenBuffer& other, const std::vector<SymbolId>& symbolMap, bool afterNewline) {
+    auto first = lineStarts.size();
+    lineStarts.insert(lineStarts.end(), other.lineStarts.begin(), other.lineStarts.end());
+    if (afterNewline && first < lineStarts.size()) {
+        lineStarts[first] = true;
+    }
+    kinds.insert(kinds.end(), other.kinds.begin(), other.kinds.end());
+    offsets.insert(offsets.end(), other.offsets.begin(), other.offsets.end());
+    lengths.insert(lengths.end(), other.lengths.begin(), other.lengths.end());
+    for (auto symbol : other.tokenSymbols) {
+        tokenSymbols.push_back(symbolMap[symbol]);
+    }
+    for (size_t type = 0; type < TOKEN_TYPE_COUNT; type++) {
+        kindCounts[type] += other.kindCounts[type];
+    }
+}
+
+// Returns chunkCount + 1 offsets, starting at 0 and ending at source.length(). Every inner offset follows a
+// newline that is outside string literals, raw strings and block comments, so nothing the lexer reads as one unit straddles
+// it. Comments make that state depend on everything before a position, so this is one forward pass; it only
+// classifies bytes and is much cheaper than the lexing it splits up.
+std::vector<size_t> findChunkBoundaries(std::string_view source, size_t chunkCount) {
+    enum ScanState { CODE, IN_STRING, IN_RAW_STRING, IN_LINE_COMMENT, IN_BLOCK_COMMENT };
+
+    size_t sliceLength = source.length() / chunkCount;
+    std::vector<size_t> boundaries{0};
+    ScanState state = CODE;
+    size_t pos = 0;
+
+    auto nextIs = [&](char c) { return pos < source.length() && source[pos] == c; };
+
+    for (size_t i = 1; i < chunkCount && pos < source.length(); i++) {
+        size_t target = i * sliceLength;
+        bool found = false;
+
+        while (!found && pos < source.length()) {
+            char c = source[pos++];
+            switch (state) {
+                case CODE:
+                    if (c == '"') {
+                        state = IN_STRING;
+                    } else if (c == '`') {
+                        state = IN_RAW_STRING;
+                    } else if (c == '/' && nextIs('/')) {
+                        state = IN_LINE_COMMENT;
+                        pos++;
+                    } else if (c == '/' && nextIs('*')) {
+                        state = IN_BLOCK_COMMENT;
+                        pos++;
+                    } else if (c == '\n') {
+                        found = pos > target;
+                    }
+                    break;
+                case IN_STRING:
+                    // Mirrors Lexer::readString: an escape takes the next byte unless it is a newline, which
+                    // ends an unterminated literal.
+                    if (c == '\\' && !nextIs('\n')) {
+                        pos++;
+                    } else if (c == '"') {
+                        state = CODE;
+                    } else if (c == '\n') {
+                        state = CODE;
+                        found = pos > target;
+                    }
+                    break;
+                case IN_RAW_STRING:
+                    if (c == '`') state = CODE;
+                    break;
+                case IN_LINE_COMMENT:
+                    if (c == '\n') {
+                        state = CODE;
+                        found = pos > target;
+                    }
+                    break;
+                case IN_BLOCK_COMMENT:
+                    if (c == '*' && nextIs('/')) {
+                        state = CODE;
+                        pos++;
+                    }
+                    break;
+            }
+        }
+
+        if (found && pos < source.length()) {
+            boundaries.push_back(pos);
+        }
+    }
+    boundaries.push_back(source.length());
+
+    return boundaries;
+}
+
+Token TokenBuffer::at(size_t i) const {
+    if (i >= kinds.size()) {
+        i = kinds.size() - 1;
+    }
+    Token token{kinds[i], source.substr(offsets[i], lengths[i]), offsets[i]};
+    token.Symbol = tokenSymbols[i];
+    token.StartsLine = lineStarts[i];
+    return token;
+}
+
+// Counts the elements of a comma separated list opened just before `start`, up to the matching `end`.
+size_t TokenBuffer::estimateListLength(size_t start, TokenType end) const {
+    size_t elements = 1;
+    int depth = 0;
+
+    for (size_t i = start; i < kinds.size(); i++) {
+        switch (kinds[i]) {
+            case LPAREN:
+            case LBRACKET:
+            case LBRACE:
+                depth++;
+                break;
+            case RPAREN:
+            case RBRACKET:
+            case RBRACE:
+                if (depth == 0) {
+                    return kinds[i] == end ? elements : 0;
+                }
+                depth--;
+                break;
+            case COMMA:
+                if (depth == 0) elements++;
+                break;
+            case END_OF_FILE:
+                return 0;
+            default:
+                break;
+        }
+    }
+
+    return 0;
+}
+
+size_t TokenBuffer::matchingBrace(size_t open) const {
+    size_t depth = 0;
+
+    for (size_t i = open; i < kinds.size(); i++) {
+        if (kinds[i] == LBRACE) {
+            depth++;
+        } else if (kinds[i] == RBRACE && --depth == 0) {
+            return i;
+        }
+    }
+
+    return kinds.size() - 1;
+}
+
+// Brace depth is tracked, as Parser::synchronize tracks it, so that declarations inside bodies are not taken for
+// top-level ones and a range never starts inside text that recovery from a syntax error would skip. Parentheses
+// and brackets are not counted, just as synchronize does not count them. Only a named `func` starts a declaration;
+// a function literal at depth 0 is part of the statement before it.
+std::vector<size_t> TokenBuffer::declarationBoundaries(size_t count) const {
+    std::vector<size_t> boundaries{0};
+    size_t target = kinds.size() / std::max<size_t>(count, 1);
+    int depth = 0;
+
+    for (size_t i = 0; i + 1 < kinds.size() && boundaries.size() < count; i++) {
+        switch (kinds[i]) {
+            case LBRACE:
+                depth++;
+                break;
+            case RBRACE:
+                if (depth > 0) depth--;
+                break;
+            case FUNCTION:
+            case VAR:
+            case CONST:
+                if (depth == 0 && i >= boundaries.back() + target && (kinds[i] != FUNCTION || kinds[i + 1] == IDENTIFIER)) {
+                    boundaries.push_back(i);
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    boundaries.push_back(kinds.size() - 1);
+    return boundaries;
+}
@@ -0,0 +1,52 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_TOKENBUFFER_H
+#define GO_TO_TS_SIMPLE_COMPILER_TOKENBUFFER_H
+
+#include <array>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "lexer.h"
+
+// Whole-file token stream stored as parallel arrays. Literals are rebuilt on demand as views into `source`,
+// which belongs to the Lexer the buffer was filled from. The last entry is always END_OF_FILE.
+// Identifier symbols refer to symbolTable(), which the chunks lexed in parallel are merged into.
+class TokenBuffer {
+public:
+    static constexpr size_t minParallelChunk = 1 << 20;
+
+    explicit TokenBuffer(Lexer& lexer);
+    // Splits `source` at newlines outside string literals, raw strings and block comments and lexes the pieces on up to `threadCount`
+    // threads, none of them given less than `minChunk` bytes. The resulting stream is identical to lexing `source` with a single Lexer.
+    TokenBuffer(std::string_view source, unsigned threadCount, size_t minChunk = minParallelChunk);
+
+    inline size_t size() const { return kinds.size(); }
+    Token at(size_t i) const;
+    inline size_t count(TokenType type) const { return kindCounts[type]; }
+    inline const std::shared_ptr<SymbolTable>& symbolTable() const { return symbols; }
+
+    size_t estimateListLength(size_t start, TokenType end) const;
+    // Index of the `}` matching the `{` at `open`, or of END_OF_FILE if it is never closed.
+    size_t matchingBrace(size_t open) const;
+    // Splits the stream into at most `count` ranges of similar token counts, each starting at a top-level `func`,
+    // `var` or `const`. Returns the start of each range, then the index of END_OF_FILE.
+    std::vector<size_t> declarationBoundaries(size_t count) const;
+
+private:
+    explicit TokenBuffer(std::string_view source) : source(source) {}
+
+    std::string_view source;
+    std::vector<TokenType> kinds;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<SymbolId> tokenSymbols;
+    std::vector<bool> lineStarts;
+    std::shared_ptr<SymbolTable> symbols;
+    std::array<size_t, TOKEN_TYPE_COUNT> kindCounts{};
+
+    void lexAll(Lexer& lexer, bool keepEndOfFile);
+    void append(const TokenBuffer& other, const std::vector<SymbolId>& symbolMap, bool afterNewline);
+};
+
+std::vector<size_t> findChunkBoundaries(std::string_view source, size_t chunkCount);
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_TOKENBUFFER_H
@@ -0,0 +1,67 @@
+#include "tokenPipe.h"
+
+#include <stdexcept>
+
+TokenPipe::TokenPipe(Lexer& lexer, size_t capacity) : lexer(lexer) {
+    if (lexer.isStreaming()) {
+        throw std::runtime_error("A streaming lexer cannot feed a token pipe");
+    }
+    size_t size = batchSize;
+    while (size < capacity) size <<= 1;
+    ring.resize(size);
+    mask = size - 1;
+    producer = std::thread([this]() { produce(); });
+}
+
+TokenPipe::~TokenPipe() {
+    stopping.store(true, std::memory_order_relaxed);
+    producer.join();
+}
+
+void TokenPipe::produce() {
+    size_t writeIndex = 0;
+    size_t writeLimit = ring.size();
+
+    try {
+        while (true) {
+            auto token = lexer.nextToken();
+
+            while (writeIndex == writeLimit) {
+                written.store(writeIndex, std::memory_order_release);
+                writeLimit = consumed.load(std::memory_order_acquire) + ring.size();
+                if (writeIndex != writeLimit) break;
+                if (stopping.load(std::memory_order_relaxed)) return;
+                std::this_thread::yield();
+            }
+
+            ring[writeIndex++ & mask] = token;
+            bool last = token.Type == END_OF_FILE;
+            // Repeated by next() once the ring has drained; the consumer only reads it after `finished` is set.
+            if (last) endOfFile = token;
+            if (last || writeIndex % batchSize == 0) {
+                written.store(writeIndex, std::memory_order_release);
+            }
+            if (last) break;
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    finished.store(true, std::memory_order_release);
+}
+
+// Hands the slots read so far back to the producer, then waits for it to publish more. Returns false once the
+// whole stream has been read.
+bool TokenPipe::waitForTokens() {
+    consumed.store(readIndex, std::memory_order_release);
+
+    while (true) {
+        bool ended = finished.load(std::memory_order_acquire);
+        readLimit = written.load(std::memory_order_acquire);
+        if (readIndex != readLimit) return true;
+        if (ended) {
+            if (error) std::rethrow_exception(error);
+            return false;
+        }
+        std::this_thread::yield();
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_TOKENPIPE_H
+#define GO_TO_TS_SIMPLE_COMPILER_TOKENPIPE_H
+
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <vector>
+#include "lexer.h"
+
+// Runs a Lexer on its own thread and hands its tokens to one consumer through a bounded single-producer,
+// single-consumer ring, so parsing overlaps with lexing. The stream is exactly what the Lexer would return, ending
+// with END_OF_FILE, which next() keeps returning. Positions are published in batches, so each side touches the
+// other's counter once per batch rather than once per token. The lexer must not be streaming: literals have to stay
+// valid after the ring slot that held them is reused.
+class TokenPipe {
+public:
+    static constexpr size_t defaultCapacity = 1 << 12;
+
+    explicit TokenPipe(Lexer& lexer, size_t capacity = defaultCapacity);
+    TokenPipe(const TokenPipe&) = delete;
+    TokenPipe& operator=(const TokenPipe&) = delete;
+    ~TokenPipe();
+
+    // Rethrows on the consumer's thread anything the lexer threw.
+    inline Token next() {
+        if (readIndex == readLimit && !waitForTokens()) return endOfFile;
+        return ring[readIndex++ & mask];
+    }
+    inline const std::shared_ptr<SymbolTable>& symbolTable() const { return lexer.symbolTable(); }
+private:
+    static constexpr size_t batchSize = 64;
+
+    Lexer& lexer;
+    std::vector<Token> ring;
+    size_t mask;
+
+    // Tokens written and tokens consumed since the start, each published by its own side and read by the other.
+    alignas(64) std::atomic<size_t> written{0};
+    alignas(64) std::atomic<size_t> consumed{0};
+    std::atomic<bool> finished{false};
+    std::atomic<bool> stopping{false};
+    std::exception_ptr error;
+
+    // Consumer side: the next slot to read and the last published write position it has seen.
+    alignas(64) size_t readIndex = 0;
+    size_t readLimit = 0;
+    // The lexer's END_OF_FILE token, at the offset where the input ends.
+    Token endOfFile{END_OF_FILE, ""};
+
+    std::thread producer;
+
+    void produce();
+    bool waitForTokens();
+};
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_TOKENPIPE_H
@@ -0,0 +1,17 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_UTF8_H
+#define GO_TO_TS_SIMPLE_COMPILER_UTF8_H
+
+#include <cstddef>
+#include <string>
+
+// Decodes the code point starting at `data`. Returns its encoded length, or 0 for a truncated, overlong or surrogate
+// sequence.
+size_t decodeUtf8(const char* data, size_t length, char32_t& codePoint);
+void appendUtf8(std::string& out, char32_t codePoint);
+
+// Whether a non-ASCII code point is a letter, which may start an identifier, or a decimal digit, which may follow
+// its first character. Combining marks, punctuation and symbols are neither, as in Go.
+bool isUnicodeLetter(char32_t codePoint);
+bool isUnicodeDigit(char32_t codePoint);
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_UTF8_H
@@ -1,46 +1,182 @@
+#include <exception>
 #include <iostream>
-#include <fstream>
-#include <sstream>
 #include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 #include "lexer/lexer.h"
 #include "parser/parser.h"
 #include "compiler/compiler.h"
 
-std::string preprocessInputFile(const std::string& filename) {
-    std::ifstream file(filename);
-    std::string line;
-    std::stringstream ss;
+struct CompileOptions {
+    std::string filename = "input.go";
+    bool pretokenize = false;
+    unsigned lexThreads = 1;
+    unsigned parseThreads = 1;
+    bool stream = false;
+    bool pipeline = false;
+    // Compile each top-level statement as soon as it is parsed instead of building the whole Program first.
+    bool emitAsParsed = false;
+    // Parse only the functions reachable from main and these entry points.
+    bool reachableOnly = false;
+    std::vector<std::string> entryPoints;
+};
+
+CompileOptions parseCommandLine(int argc, char* argv[]) {
+    CompileOptions options;
 
-    if (!file.is_open()) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--pretokenize") {
+            options.pretokenize = true;
+        } else if (arg.rfind("--lex-threads=", 0) == 0) {
+            options.pretokenize = true;
+            options.lexThreads = std::stoul(arg.substr(std::string("--lex-threads=").length()));
+            if (options.lexThreads == 0) options.lexThreads = std::thread::hardware_concurrency();
+        } else if (arg.rfind("--parse-threads=", 0) == 0) {
+            options.pretokenize = true;
+            options.parseThreads = std::stoul(arg.substr(std::string("--parse-threads=").length()));
+            if (options.parseThreads == 0) options.parseThreads = std::thread::hardware_concurrency();
+        } else if (arg == "--reachable-only") {
+            options.pretokenize = true;
+            options.reachableOnly = true;
+        } else if (arg.rfind("--entry=", 0) == 0) {
+            options.pretokenize = true;
+            options.reachableOnly = true;
+            options.entryPoints.push_back(arg.substr(std::string("--entry=").length()));
+        } else if (arg == "--pipeline") {
+            options.pipeline = true;
+        } else if (arg == "--emit-as-parsed") {
+            options.emitAsParsed = true;
+        } else if (arg == "--stream") {
+            options.stream = true;
+        } else if (arg.rfind("--", 0) == 0) {
+            throw std::runtime_error("Unknown option: " + arg);
+        } else {
+            options.filename = arg;
+        }
+    }
+
+    if (options.pipeline && (options.stream || options.pretokenize)) {
+        throw std::runtime_error("--pipeline cannot be combined with --stream, --pretokenize, --lex-threads, --parse-threads, --reachable-only or --entry");
+    }
+    if (options.stream && options.pretokenize) {
+        throw std::runtime_error("--stream cannot be combined with --pretokenize, --lex-threads, --parse-threads, --reachable-only or --entry");
+    }
+    // With --pipeline, the lexer thread would intern names while the compiler reads the symbol table.
+    if (options.emitAsParsed && (options.pipeline || options.reachableOnly || options.parseThreads > 1)) {
+        throw std::runtime_error("--emit-as-parsed cannot be combined with --pipeline, --parse-threads, --reachable-only or --entry");
+    }
+    if (options.reachableOnly && options.parseThreads > 1) {
+        throw std::runtime_error("--parse-threads cannot be combined with --reachable-only or --entry");
+    }
+
+    return options;
+}
+
+// Prints every syntax error and returns whether there were any; a Program with errors is not compiled.
+bool reportErrors(const std::string& filename, const std::vector<Diagnostic>& errors, std::string_view source) {
+    for (const auto& error : errors) {
+        std::cerr << filename << ":" << formatDiagnostic(error, source) << std::endl;
+    }
+    return !errors.empty();
+}
+
+// Statements after the first syntax or compile error are still parsed, for their diagnostics, but no longer emitted.
+// A compile error is only raised once the whole file has parsed without syntax errors, as it would be after
+// parseProgram.
+bool compileAsParsed(Parser& parser, const std::string& filename, std::string_view source) {
+    Compiler compiler("./output.ts");
+    std::exception_ptr compileError;
+    parser.parseStatements([&](const Program& program, NodeId statement) {
+        if (!parser.errors.empty() || compileError) return;
+        try {
+            compiler.compileStatement(program, statement);
+        } catch (const std::runtime_error&) {
+            compileError = std::current_exception();
+        }
+    });
+    if (reportErrors(filename, parser.errors, source)) return false;
+    if (compileError) std::rethrow_exception(compileError);
+    return true;
+}
+
+// Lexes straight from the file through a fixed-size window instead of loading it into memory first.
+bool streamInputFile(const std::string& filename, bool emitAsParsed) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
         throw std::runtime_error("Could not open the file: " + filename);
     }
 
-    while (getline(file, line)) {
-        if (line.find("package") == 0 || line.find("import") == 0 || line.find("//") == 0) {
-            continue;
+    FdSource file(fd);
+    std::unique_ptr<Program> output;
+    std::vector<Diagnostic> errors;
+    try {
+        Lexer newLexer(&file);
+        Parser newParser{&newLexer};
+        if (emitAsParsed) {
+            bool compiled = compileAsParsed(newParser, filename, {});
+            close(fd);
+            return compiled;
         }
-        ss << line << '\n';
+        output = newParser.parseProgram();
+        errors = std::move(newParser.errors);
+    } catch (...) {
+        close(fd);
+        throw;
     }
+    close(fd);
+    // The streamed source is gone by now, so positions are byte offsets.
+    if (reportErrors(filename, errors, {})) return false;
 
-    file.close();
-    return ss.str();
+    Compiler compiler("./output.ts");
+    compiler.compile(*output);
+    return true;
 }
 
-void compileInputFile(const std::string& input) {
-    Lexer newLexer(input);
-    Parser newParser{&newLexer};
-    auto output = newParser.parseProgram();
+// The file is mapped read-only and lexed in place; package, import and comments are handled by the lexer.
+bool compileInputFile(const CompileOptions& options) {
+    MappedFile file(options.filename);
+    Lexer newLexer(file.contents());
+    std::unique_ptr<Program> output;
+    std::vector<Diagnostic> errors;
+    if (options.pretokenize) {
+        TokenBuffer tokens(newLexer.source(), options.lexThreads);
+        if (options.parseThreads > 1) {
+            output = Parser::parseInParallel(&tokens, options.parseThreads, errors);
+        } else {
+            Parser newParser{&tokens};
+            if (options.emitAsParsed) return compileAsParsed(newParser, options.filename, newLexer.source());
+            output = options.reachableOnly ? newParser.parseReachable(options.entryPoints) : newParser.parseProgram();
+            errors = std::move(newParser.errors);
+        }
+    } else if (options.pipeline) {
+        TokenPipe pipe(newLexer);
+        Parser newParser{&newLexer, &pipe};
+        output = newParser.parseProgram();
+        errors = std::move(newParser.errors);
+    } else {
+        Parser newParser{&newLexer};
+        if (options.emitAsParsed) return compileAsParsed(newParser, options.filename, newLexer.source());
+        output = newParser.parseProgram();
+        errors = std::move(newParser.errors);
+    }
+    if (reportErrors(options.filename, errors, newLexer.source())) return false;
+
     Compiler compiler("./output.ts");
-    compiler.compile(std::move(output));
+    compiler.compile(*output);
+    return true;
 }
 
-int main() {
-    std::string filename = "input.go";
+int main(int argc, char* argv[]) {
     try {
-        std::string processedInput = preprocessInputFile(filename);
-        compileInputFile(processedInput);
+        CompileOptions options = parseCommandLine(argc, argv);
+        bool compiled = options.stream ? streamInputFile(options.filename, options.emitAsParsed) : compileInputFile(options);
+        if (!compiled) return 1;
     } catch (std::runtime_error& e) {
         std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
     }
     return 0;
 }
@@ -0,0 +1,212 @@
+#include "incrementalParser.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// Reads the source from a given offset, across the gap.
+class IncrementalParser::GapSource : public ByteSource {
+public:
+    GapSource(const IncrementalParser& parser, size_t from) : parser(parser), position(from) {}
+
+    size_t read(char* buffer, size_t capacity) override {
+        size_t total = 0;
+        while (total < capacity && position < parser.sourceLength()) {
+            bool beforeGap = position < parser.gapStart;
+            size_t index = beforeGap ? position : position + (parser.gapEnd - parser.gapStart);
+            size_t available = beforeGap ? parser.gapStart - position : parser.text.length() - index;
+            size_t count = std::min(available, capacity - total);
+            std::memcpy(buffer + total, parser.text.data() + index, count);
+            total += count;
+            position += count;
+        }
+        return total;
+    }
+
+private:
+    const IncrementalParser& parser;
+    size_t position;
+};
+
+// Tokens are read a small window at a time, as only the text around an edit is lexed again.
+static constexpr size_t relexWindowSize = 4 << 10;
+static constexpr size_t minGapSize = 4 << 10;
+
+IncrementalParser::IncrementalParser(std::string source) : text(std::move(source)), gapStart(text.length()), gapEnd(text.length()) {
+    rebuild();
+}
+
+std::string_view IncrementalParser::source() {
+    moveGap(sourceLength());
+    return std::string_view(text).substr(0, gapStart);
+}
+
+void IncrementalParser::moveGap(size_t offset) {
+    if (offset < gapStart) {
+        std::memmove(&text[gapEnd - (gapStart - offset)], &text[offset], gapStart - offset);
+    } else if (offset > gapStart) {
+        std::memmove(&text[gapStart], &text[gapEnd], offset - gapStart);
+    }
+    gapEnd += offset - gapStart;
+    gapStart = offset;
+}
+
+void IncrementalParser::rebuild() {
+    ast = std::make_unique<Program>();
+    ast->symbols = symbols;
+    units.clear();
+    shiftedFrom = 0;
+    pendingShift = 0;
+    garbageNodes = 0;
+    reparse(0, 0, 0);
+}
+
+// Settles the pending shift of the units between `index` and shiftedFrom, so that it applies from `index` on.
+void IncrementalParser::moveShift(size_t index) {
+    for (auto i = index; i < shiftedFrom; i++) {
+        units[i].start -= pendingShift;
+        units[i].lookaheadEnd -= pendingShift;
+    }
+    for (auto i = shiftedFrom; i < index; i++) {
+        units[i].start += pendingShift;
+        units[i].lookaheadEnd += pendingShift;
+    }
+    shiftedFrom = index;
+}
+
+// Index of the first unit starting at or after `offset`.
+size_t IncrementalParser::findUnit(uint64_t offset) const {
+    size_t low = 0;
+    size_t high = units.size();
+    while (low < high) {
+        auto middle = low + (high - low) / 2;
+        if (startOf(middle) < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+size_t IncrementalParser::apply(const TextEdit& edit) {
+    if (edit.offset > sourceLength() || edit.removed > sourceLength() - edit.offset) {
+        throw std::runtime_error("Edit is outside the source");
+    }
+    moveGap(edit.offset);
+    gapEnd += edit.removed;
+    if (gapEnd - gapStart < edit.inserted.length()) {
+        // Regrown in proportion to the source, so growing is amortized over many edits.
+        size_t gap = edit.inserted.length() + std::max(minGapSize, sourceLength() / 8);
+        text.insert(gapEnd, gap - (gapEnd - gapStart), '\0');
+        gapEnd = gapStart + gap;
+    }
+    std::memcpy(&text[gapStart], edit.inserted.data(), edit.inserted.length());
+    gapStart += edit.inserted.length();
+    auto delta = static_cast<int64_t>(edit.inserted.length()) - static_cast<int64_t>(edit.removed);
+
+    // The first statement that read the edited text. Whether a token ends where it does can depend on the two bytes
+    // after it, as in `1..`, so an edit just past a statement's lookahead still reaches it.
+    auto first = findUnit(edit.offset);
+    while (first > 0 && edit.offset <= lookaheadEndOf(first - 1) + 1) {
+        first--;
+    }
+
+    auto reparsed = reparse(first, edit.offset + edit.removed, delta);
+    if (garbageNodes > ast->nodes.size() / 2) {
+        rebuild();
+    }
+    return reparsed;
+}
+
+// Parses from units[first] until, between two statements, the parser reaches the start of a statement that lies
+// wholly after the edit. The text from there on is unchanged, and how it parses depends only on that text, as
+// neither the lexer nor the parser carries state past a top-level statement boundary, so the rest would parse as
+// before. The statements in between are replaced. `editEnd` is the end of the removed text, in offsets from before
+// the edit.
+size_t IncrementalParser::reparse(size_t first, uint64_t editEnd, int64_t delta) {
+    moveShift(first);
+    uint64_t from = first == 0 ? 0 : startOf(first);
+    GapSource input(*this, from);
+    Lexer lexer(&input, relexWindowSize, from);
+    lexer.shareSymbolTable(symbols);
+    Parser parser(&lexer);
+    parser.program = ast.get();
+
+    auto next = std::max(findUnit(editEnd), first);
+    bool synced = false;
+    std::vector<Unit> parsed;
+    auto statementIndex = first < units.size() ? units[first].statementIndex : ast->statements.size();
+
+    while (!parser.currentTokenIs(END_OF_FILE)) {
+        // A string token's offset is that of its contents, past the opening quote.
+        bool quoted = parser.currentTokenIs(STRING) || parser.currentTokenIs(RAW_STRING);
+        auto start = parser.currentToken.Offset - quoted;
+        while (next < units.size() && startOf(next) + delta < start) {
+            next++;
+        }
+        if (next < units.size() && startOf(next) + delta == start) {
+            synced = true;
+            break;
+        }
+
+        Unit unit{start, 0, NO_NODE, statementIndex, ast->nodes.size(), {}};
+        auto errorCount = parser.errors.size();
+        unit.statement = parser.parseStatement();
+        unit.nodeCount = ast->nodes.size() - unit.nodeCount;
+        // nextToken is the furthest token lexed; a string's closing quote is not part of its literal.
+        quoted = parser.nextTokenIs(STRING) || parser.nextTokenIs(RAW_STRING);
+        unit.lookaheadEnd = parser.nextToken.Offset + parser.nextToken.Literal.length() + quoted;
+        for (auto i = errorCount; i < parser.errors.size(); i++) {
+            unit.errors.push_back({parser.errors[i].offset - start, std::move(parser.errors[i].message)});
+        }
+        if (unit.statement) statementIndex++;
+        parsed.push_back(std::move(unit));
+    }
+
+    auto end = synced ? next : units.size();
+    auto count = parsed.size();
+    for (auto i = first; i < end; i++) {
+        garbageNodes += units[i].nodeCount;
+    }
+
+    // Typing within a statement keeps the statements' layout, and only the replaced ones are touched. The units
+    // after them are moved along with the pending shift.
+    auto hasStatement = [](const Unit& unit) { return unit.statement != NO_NODE; };
+    bool sameLayout = count == end - first && std::equal(parsed.begin(), parsed.end(), units.begin() + first,
+        [&](const Unit& a, const Unit& b) { return hasStatement(a) == hasStatement(b); });
+    if (sameLayout) {
+        for (size_t i = 0; i < count; i++) {
+            if (hasStatement(parsed[i])) ast->statements[parsed[i].statementIndex] = parsed[i].statement;
+            units[first + i] = std::move(parsed[i]);
+        }
+        shiftedFrom = first + count;
+        pendingShift += delta;
+        return count;
+    }
+
+    units.erase(units.begin() + first, units.begin() + end);
+    units.insert(units.begin() + first, std::make_move_iterator(parsed.begin()), std::make_move_iterator(parsed.end()));
+    ast->statements.clear();
+    for (size_t i = 0; i < units.size(); i++) {
+        if (i >= first + count) {
+            units[i].start += pendingShift + delta;
+            units[i].lookaheadEnd += pendingShift + delta;
+        }
+        units[i].statementIndex = ast->statements.size();
+        if (hasStatement(units[i])) ast->statements.push_back(units[i].statement);
+    }
+    shiftedFrom = units.size();
+    pendingShift = 0;
+    return count;
+}
+
+std::vector<Diagnostic> IncrementalParser::errors() const {
+    std::vector<Diagnostic> all;
+    for (size_t i = 0; i < units.size(); i++) {
+        for (const auto& error : units[i].errors) {
+            all.push_back({startOf(i) + error.offset, error.message});
+        }
+    }
+    return all;
+}
@@ -0,0 +1,80 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_INCREMENTALPARSER_H
+#define GO_TO_TS_SIMPLE_COMPILER_INCREMENTALPARSER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "parser.h"
+
+// Replaces `removed` bytes at `offset` with `inserted`.
+struct TextEdit {
+    uint64_t offset;
+    uint64_t removed;
+    std::string inserted;
+};
+
+// Owns a source file and keeps its Program up to date as the file is edited. Each edit re-lexes and re-parses only
+// the top-level statements it touches: parsing restarts at the first statement that read the edited text, which may
+// be one before the edit, and stops at the first untouched statement it lines up with again. That statement and every
+// other untouched one keep their nodes. The AST holds no source positions, and literals are copied, so kept
+// statements need no fixing up; only their start offsets move.
+//
+// Typing within a statement keeps the layout of the statements, and the offsets after the edit move lazily: the
+// source is a gap buffer kept at the last edit, and the offsets after it carry a pending shift. Such an edit costs
+// the text and statements between it and the previous edit. An edit that adds, removes or splits statements changes
+// the layout instead: the statement list, and the offsets of every later statement, are rebuilt. That is O(n) in the
+// number of statements and not incremental.
+class IncrementalParser {
+public:
+    explicit IncrementalParser(std::string source);
+
+    // Returns the number of top-level statements that were parsed again.
+    size_t apply(const TextEdit& edit);
+
+    // Closes the gap, which costs a move of the text after the last edit.
+    std::string_view source();
+    inline size_t sourceLength() const { return text.length() - (gapEnd - gapStart); }
+    // Statements are in source order; nodes of replaced statements stay in the Program until it is rebuilt.
+    inline const Program& program() const { return *ast; }
+    std::vector<Diagnostic> errors() const;
+
+private:
+    // One top-level statement. Package and import clauses, and statements with syntax errors, have no node.
+    struct Unit {
+        uint64_t start;
+        // End of the last token read while parsing the statement. Lookahead, and a syntax error found at the token
+        // after the one parsing resumes from, reach into the statements after it.
+        uint64_t lookaheadEnd;
+        NodeId statement;
+        // Position of `statement` in Program::statements, or of the next statement when it has none.
+        size_t statementIndex;
+        size_t nodeCount;
+        // Offsets relative to `start`, so they move with it.
+        std::vector<Diagnostic> errors;
+    };
+
+    // The source is text[0, gapStart) followed by text[gapEnd, end).
+    std::string text;
+    size_t gapStart = 0;
+    size_t gapEnd = 0;
+    std::shared_ptr<SymbolTable> symbols = std::make_shared<SymbolTable>();
+    std::unique_ptr<Program> ast;
+    std::vector<Unit> units;
+    // Units from shiftedFrom on start pendingShift bytes away from their recorded offsets.
+    size_t shiftedFrom = 0;
+    int64_t pendingShift = 0;
+    // Nodes that belong to replaced statements. Once they outnumber the live ones, the Program is rebuilt.
+    size_t garbageNodes = 0;
+
+    class GapSource;
+
+    void moveGap(size_t offset);
+    inline uint64_t startOf(size_t i) const { return units[i].start + (i >= shiftedFrom ? pendingShift : 0); }
+    inline uint64_t lookaheadEndOf(size_t i) const { return units[i].lookaheadEnd + (i >= shiftedFrom ? pendingShift : 0); }
+    void moveShift(size_t index);
+    size_t findUnit(uint64_t offset) const;
+    void rebuild();
+    size_t reparse(size_t first, uint64_t editEnd, int64_t delta);
+};
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_INCREMENTALPARSER_H
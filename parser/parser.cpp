@@ -3,31 +3,58 @@
 //
 
 #include "parser.h"
+#include "../lexer/numericLiteral.h"
 
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 
-bool startsWithType(const std::string& str) {
-    const std::string prefix = "type_";
-    if (str.length() < prefix.length()) {
-        return false;
+// Kind of node a literal token becomes, or NODE_NONE for any other token.
+static NodeKind literalTokenKind(TokenType t) {
+    switch (t) {
+        case INT: return NODE_INTEGER;
+        case FLOAT: return NODE_FLOAT;
+        case STRING:
+        case RAW_STRING: return NODE_STRING;
+        case TRUE:
+        case FALSE: return NODE_BOOLEAN;
+        default: return NODE_NONE;
     }
-    return str.substr(0, prefix.length()) == prefix;
 }
 
-std::unordered_map<TokenType, int> precedences = {
-        {EQ,       EQUALS},
-        {NOT_EQ,   EQUALS},
-        {LESS_THAN,       LESSORGREATER},
-        {GREATER_THAN,       LESSORGREATER},
-        {PLUS,     SUM},
-        {MINUS,    SUM},
-        {SLASH,    PRODUCT},
-        {ASTERISK, PRODUCT},
-        {LPAREN,   CALL},
-        {LBRACKET, INDEX},
-};
+// How a token is named in a diagnostic.
+static std::string describeToken(const Token& token) {
+    if (token.Type == END_OF_FILE) return "end of file";
+    return "'" + std::string(token.Literal) + "'";
+}
+
+// How a type is written in Go, for diagnostics.
+static std::string goTypeName(const TypeTable& types, TypeId type) {
+    if (types.isArray(type)) return "[]" + goTypeName(types, types.element(type));
+    switch (type) {
+        case TYPE_INT: return "int";
+        case TYPE_FLOAT: return "float64";
+        case TYPE_STRING: return "string";
+        case TYPE_BOOL: return "bool";
+        default: return "an unknown type";
+    }
+}
 
-bool Parser::checkNextTokenAndAdvance(const TokenType& t) {
+std::string formatDiagnostic(const Diagnostic& diagnostic, std::string_view source) {
+    if (diagnostic.offset > source.length()) {
+        return "offset " + std::to_string(diagnostic.offset) + ": " + diagnostic.message;
+    }
+    auto before = source.substr(0, diagnostic.offset);
+    auto line = std::count(before.begin(), before.end(), '\n') + 1;
+    auto lineStart = before.rfind('\n');
+    auto column = lineStart == std::string_view::npos ? diagnostic.offset + 1 : diagnostic.offset - lineStart;
+    return std::to_string(line) + ":" + std::to_string(column) + ": " + diagnostic.message;
+}
+
+bool Parser::checkNextTokenAndAdvance(TokenType t) {
     if (nextTokenIs(t)) {
         getNextToken();
         return true;
@@ -35,9 +62,63 @@ bool Parser::checkNextTokenAndAdvance(const TokenType& t) {
     return false;
 }
 
-std::unique_ptr<Node> Parser::parseDeclarationNode(DeclarationType declType) {
-    auto node = std::make_unique<Declaration>();
-    if (declType == CONST_DECL) node->isConstant = true;
+// An unclosed block fails at end of file along with every block around it; only the innermost one is reported. Only
+// the last statement can reach the end of the file, so this never merges diagnostics of two statements.
+void Parser::fail(const Token& at, const std::string& message) {
+    if (!(at.Type == END_OF_FILE && !errors.empty() && errors.back().offset == at.Offset)) {
+        errors.push_back({at.Offset, message});
+    }
+    throw SyntaxError{};
+}
+
+void Parser::expectNext(TokenType t, const char* expected) {
+    if (!checkNextTokenAndAdvance(t)) {
+        fail(nextToken, std::string("expected ") + expected + ", found " + describeToken(nextToken));
+    }
+}
+
+static bool startsStatement(TokenType t) {
+    return t == VAR || t == CONST || t == FUNCTION || t == RETURN || t == IF || t == PRINT;
+}
+
+// Panic mode: skips to the next token after the failed statement's first one that starts a statement, or to the
+// `}` closing the enclosing block. Braces opened on the way are skipped along with their contents, and a `}` the
+// statement starts with, which closes nothing, is skipped. It may run past the end of a parallel parser's range, as
+// it would in a sequential parse; parseInParallel checks for that.
+void Parser::synchronize(uint64_t statementStart) {
+    int depth = 0;
+    while (!currentTokenIs(END_OF_FILE)) {
+        if (currentToken.Offset > statementStart && depth == 0 && (currentTokenIs(RBRACE) || startsStatement(currentToken.Type))) {
+            return;
+        }
+        if (currentTokenIs(LBRACE)) {
+            depth++;
+        } else if (currentTokenIs(RBRACE) && depth > 0) {
+            depth--;
+        }
+        getNextToken();
+    }
+}
+
+// Parses the statement at currentToken and moves past it. A statement with a syntax error yields NO_NODE; its
+// diagnostic has been recorded and parsing resumes after it.
+NodeId Parser::parseStatement() {
+    auto start = currentToken.Offset;
+    auto openExpressions = expressionStack.size();
+    try {
+        auto node = parseNode();
+        getNextToken();
+        return node;
+    } catch (const SyntaxError&) {
+        expressionStack.resize(openExpressions);
+        synchronize(start);
+        return NO_NODE;
+    }
+}
+
+NodeId Parser::parseDeclarationNode(DeclarationType declType) {
+    auto node = program->add(NODE_DECLARATION);
+    if (declType == CONST_DECL) program->node(node).flags |= IS_CONSTANT;
     if (declType == SHORT_DECL) {
         return parseShortDeclarationNode(node);
     } else if (checkNextTokenAndAdvance(IDENTIFIER)) {
@@ -47,361 +128,654 @@ std::unique_ptr<Node> Parser::parseDeclarationNode(DeclarationType declType) {
         auto var =  parseGroupedDeclarationNode(node);
         return var;
     } else {
-        throw std::runtime_error("Unknown variable declaration");
+        fail(nextToken, "expected a name or '(' after " + describeToken(currentToken) + ", found " + describeToken(nextToken));
     }
 }
 
-std::unique_ptr<Declaration> Parser::parseShortDeclarationNode(std::unique_ptr<Declaration> &node) {
-    node->name = std::make_unique<Identifier>(currentToken.Literal);
+NodeId Parser::parseShortDeclarationNode(NodeId node) {
+    auto name = program->add(NODE_IDENTIFIER);
+    program->node(name).lhs = currentToken.Symbol;
+    program->node(node).lhs = name;
     getNextToken(2);
 
     if (currentTokenIs(LBRACKET)) {
         auto arr = parseArray();
-        node->type = std::move(arr->type);
-        node->value = std::move(arr);
+        program->node(node).type = program->node(arr).type;
+        program->node(node).rhs = arr;
     } else {
-        node->value = parseRValue(LOWEST);
+        program->node(node).rhs = parseRValue(LOWEST);
     }
 
-    if (!node->type) {
+    if (!program->node(node).type) {
         parseImplicitVariableType(node);
     }
 
-    return std::move(node);
+    return node;
 }
 
-std::unique_ptr<Declaration> Parser::parseGroupedDeclarationNode(std::unique_ptr<Declaration> &node) {
+NodeId Parser::parseGroupedDeclarationNode(NodeId node) {
     getNextToken();
-    node->holdsMultipleValues = true;
+    program->node(node).flags |= HOLDS_MULTIPLE_VALUES;
+    std::vector<NodeId> declarations;
 
     while (currentTokenIs(IDENTIFIER)) {
-        auto newNode = std::make_unique<Declaration>();
-        newNode->name = parseIdentifier();
+        if (!declarations.empty() && !currentToken.StartsLine) {
+            fail(currentToken, "expected a new line or ')' after the declaration, found " + describeToken(currentToken));
+        }
+        auto newNode = program->add(NODE_DECLARATION);
+        program->node(newNode).lhs = parseIdentifier();
         getNextToken();
 
         if (currentTokenIs(LBRACKET)) {
-            newNode->type = parseType();
+            program->node(newNode).type = parseType();
             if (checkNextTokenAndAdvance(ASSIGN)) {
                 getNextToken();
-                newNode->value = std::move(parseArray());
-                node->multipleValues.push_back(std::move(newNode));
+                program->node(newNode).rhs = parseArray();
                 getNextToken();
             } else {
-                newNode->value = std::make_unique<Array>();
-                newNode->value->holdsValue = false;
-                node->multipleValues.push_back(std::move(newNode));
+                auto empty = program->add(NODE_ARRAY);
+                program->node(empty).type = program->node(newNode).type;
+                program->node(empty).flags &= ~HOLDS_VALUE;
+                program->node(newNode).rhs = empty;
                 getNextToken();
             }
 
         } else {
             if (tokenTypeIsTypeNode(currentToken.Type)) {
-                newNode->type = parseType();
+                program->node(newNode).type = parseType();
                 getNextToken();
             }
             if(currentTokenIs(ASSIGN)) {
                 getNextToken();
-                newNode->value = parseRValue(LOWEST);
-                if (!newNode->type) {
+                program->node(newNode).rhs = parseRValue(LOWEST);
+                if (!program->node(newNode).type) {
                     parseImplicitVariableType(newNode);
                 }
                 getNextToken();
 
             } else {
-                newNode->value = std::make_unique<Integer>();
-                newNode->value->holdsValue = false;
+                auto empty = program->addInteger(0);
+                program->node(empty).flags &= ~HOLDS_VALUE;
+                program->node(newNode).rhs = empty;
             }
 
         }
 
-        node->multipleValues.push_back(std::move(newNode));
+        declarations.push_back(newNode);
     }
 
-    return std::move(node);
+    if (!currentTokenIs(RPAREN)) {
+        fail(currentToken, "expected ')' to close the declaration group, found " + describeToken(currentToken));
+    }
+    program->node(node).list = program->addList(declarations);
+    return node;
 }
 
-std::unique_ptr<Declaration> Parser::parseExplicitDeclarationNode(std::unique_ptr<Declaration> &node) {
-    node->name = std::make_unique<Identifier>(currentToken.Literal);
+NodeId Parser::parseExplicitDeclarationNode(NodeId node) {
+    auto name = program->add(NODE_IDENTIFIER);
+    program->node(name).lhs = currentToken.Symbol;
+    program->node(node).lhs = name;
+    bool isConstant = program->node(node).isConstant();
 
     if(nextTokenIs(LBRACKET)) {
-        if (node->isConstant) throw std::runtime_error("Constant array!");
+        if (isConstant) fail(nextToken, "a constant cannot be an array");
         getNextToken();
-        node->type = parseType();
-    } else if (startsWithType(nextToken.Type)) {
+        program->node(node).type = parseType();
+    } else if (tokenTypeIsTypeNode(nextToken.Type)) {
         getNextToken();
-        node->type = parseType();
+        program->node(node).type = parseType();
     }
 
     if (!nextTokenIs(ASSIGN)) {
-        if (node->type) {
-            node->value = std::make_unique<Integer>();
-            node->value->holdsValue = false;
-            return std::move(node);
+        if (program->node(node).type) {
+            auto empty = program->addInteger(0);
+            program->node(empty).flags &= ~HOLDS_VALUE;
+            program->node(node).rhs = empty;
+            return node;
         } else {
-            throw std::runtime_error("Unknown declaration");
+            fail(nextToken, "expected a type or '=' after the variable name, found " + describeToken(nextToken));
         }
     }
 
     getNextToken(2);
 
     if (currentTokenIs(LBRACKET)) {
-        if (node->isConstant) throw std::runtime_error("Constant array!");
+        if (isConstant) fail(currentToken, "a constant cannot be an array");
         auto arr = parseArray();
-        node->type = std::move(arr->type);
-        node->value = std::move(arr);
+        program->node(node).type = program->node(arr).type;
+        program->node(node).rhs = arr;
     } else {
-        node->value = parseRValue(LOWEST);
+        program->node(node).rhs = parseRValue(LOWEST);
     }
 
-    if (!node->type) {
+    if (!program->node(node).type) {
         parseImplicitVariableType(node);
     }
 
-    return std::move(node);
+    return node;
 }
 
 
-void Parser::parseImplicitVariableType(std::unique_ptr<Declaration> &node) {
-    if (dynamic_cast<Integer*>(node->value.get())) {
-        node->type = std::make_unique<IntegerType>();
-    } else if (dynamic_cast<String*>(node->value.get())) {
-        node->type = std::make_unique<StringType>();
-    } else if (dynamic_cast<Boolean*>(node->value.get())) {
-        node->type = std::make_unique<BoolType>();
-    } else if (auto arr = dynamic_cast<Array*>(node->value.get())) {
-        auto arrType = std::make_unique<ArrayType>();
-        if (dynamic_cast<Integer*>(arr->elements[0].get())) {
-            arrType->subType = std::make_unique<IntegerType>();
-        } else if (dynamic_cast<String*>(arr->elements[0].get())) {
-            arrType->subType = std::make_unique<StringType>();
-        } else if (dynamic_cast<Boolean*>(arr->elements[0].get())) {
-            arrType->subType = std::make_unique<BoolType>();
+void Parser::parseImplicitVariableType(NodeId node) {
+    auto value = program->node(node).rhs;
+
+    switch (program->kind(value)) {
+        case NODE_INTEGER:
+        case NODE_FLOAT:
+        case NODE_STRING:
+        case NODE_BOOLEAN:
+        // An array literal carries its declared type, so its elements, which may be packed, are not read.
+        case NODE_ARRAY:
+            program->node(node).type = program->node(value).type;
+            break;
+        case NODE_PREFIX: {
+            // `!` makes a bool, and `-` keeps the type of its operand, which a literal has at parse time.
+            auto operand = value;
+            while (program->kind(operand) == NODE_PREFIX && program->node(operand).op == MINUS) {
+                operand = program->node(operand).rhs;
+            }
+            if (program->kind(operand) == NODE_PREFIX) {
+                program->node(node).type = TYPE_BOOL;
+            } else {
+                program->node(node).type = isLiteralKind(program->kind(operand)) ? program->node(operand).type : static_cast<TypeId>(TYPE_VOID);
+            }
+            break;
         }
-        node->type = std::move(arrType);
-    } else {
-        node->type = std::make_unique<NoType>();
+        default:
+            program->node(node).type = TYPE_VOID;
     }
 }
 
-std::unique_ptr<TypeNode> Parser::parseType() {
-    if (currentToken.Literal == LBRACKET) {
-        getNextToken(3);
-        auto type = parseType();
-        return std::make_unique<ArrayType>(std::move(type));
-    } else if (currentToken.Type == STRING_TYPE) {
-        return std::make_unique<StringType>();
-    } else if (currentToken.Type == BOOL_TYPE) {
-        return std::make_unique<BoolType>();
-    } else if (currentToken.Type == INT_TYPE) {
-        return std::make_unique<IntegerType>();
+// Parses the type starting at currentToken, leaving currentToken on its last token. Array and slice types nest, as in
+// [][3]int; both become TypeScript arrays, so the length is skipped.
+TypeId Parser::parseType() {
+    if (currentToken.Type == LBRACKET) {
+        if (nextTokenIs(INT) || nextTokenIs(VARIADIC)) {
+            getNextToken();
+        }
+        expectNext(RBRACKET, "']' in array type");
+        getNextToken();
+        return program->types.arrayOf(parseType());
+    } else if (currentToken.Type == STRING_TYPE || currentToken.Type == BOOL_TYPE || currentToken.Type == INT_TYPE) {
+        return TypeTable::primitive(currentToken.Type);
     } else {
-        throw std::runtime_error("incorrect subType: " + currentToken.Literal);
+        fail(currentToken, "expected a type, found " + describeToken(currentToken));
     }
 }
 
-std::unique_ptr<Function> Parser::parseFunctionDeclaration() {
-    auto func = std::make_unique<Function>();
+NodeId Parser::parseFunctionDeclaration() {
+    auto func = program->add(NODE_FUNCTION);
 
     if(!nextTokenIs(IDENTIFIER)) {
-        throw std::runtime_error("Unhandled function declaration: function name is missing");
+        fail(nextToken, "expected a function name, found " + describeToken(nextToken));
     }
 
     getNextToken();
 
     if (currentTokenIs(IDENTIFIER)) {
-        func->funcName = parseIdentifier()->string();
+        program->node(func).lhs = currentToken.Symbol;
         getNextToken();
     }
 
-    func->parameters = parseFunctionParameters();
+    program->node(func).list = parseFunctionParameters();
 
-    if (startsWithType(nextToken.Type)) {
+    if (tokenTypeIsTypeNode(nextToken.Type) || nextTokenIs(LBRACKET)) {
         getNextToken();
-        func->type = parseType();
-    } else if (nextTokenIs(LBRACKET)) {
-        getNextToken(3);
-        func->type = std::make_unique<ArrayType>(parseType());
+        program->node(func).type = parseType();
     }
 
-    if(!checkNextTokenAndAdvance(LBRACE)) {
-        return nullptr;
+    expectNext(LBRACE, "'{' to open the function body");
+
+    // A body whose braces never balance runs to the end of the file, and error recovery may end it elsewhere than
+    // counting does. It is parsed now, as a full parse would, so that its diagnostics and those after it are the same.
+    if (deferBodies) {
+        auto open = cursor - 2;
+        auto close = tokens->matchingBrace(open);
+        if (close + 1 < tokens->size()) {
+            rewind(close + 2);
+            program->node(func).flags |= DEFERRED_BODY;
+            program->node(func).extra = static_cast<uint32_t>(open);
+            return func;
+        }
     }
 
-    func->body = parseBlockNode();
+    program->node(func).rhs = parseBlockNode();
 
     return func;
 }
 
-std::unique_ptr<CodeBlock> Parser::parseBlockNode() {
-    auto block = std::make_unique<CodeBlock>();
+NodeId Parser::parseBlockNode() {
+    auto block = program->add(NODE_CODE_BLOCK);
+    std::vector<NodeId> nodes;
     getNextToken();
 
-
     while (!currentTokenIs(RBRACE) && !currentTokenIs(END_OF_FILE)) {
-        auto node = parseNode();
+        auto node = parseStatement();
         if (node) {
-            block->nodes.emplace_back(std::move(node));
+            nodes.push_back(node);
         }
-        getNextToken();
+    }
+    if (currentTokenIs(END_OF_FILE)) {
+        fail(currentToken, "expected '}' to close the block, found end of file");
     }
 
+    program->node(block).list = program->addList(nodes);
     return block;
 }
 
-std::vector<std::unique_ptr<Identifier>> Parser::parseFunctionParameters() {
-    auto params = std::vector<std::unique_ptr<Identifier>>{};
-    std::vector<std::unique_ptr<Identifier>> untypedParamVector{};
+NodeRange Parser::parseFunctionParameters() {
+    auto params = std::vector<NodeId>{};
+    std::vector<NodeId> untypedParamVector{};
     if (nextTokenIs(RPAREN)) {
         getNextToken();
-        return params;
+        return {};
     }
 
-    getNextToken();
+    expectNext(IDENTIFIER, "a parameter name");
 
-    auto param = std::make_unique<Identifier>(currentToken.Literal);
-    if (startsWithType(nextToken.Type) || nextTokenIs(LBRACKET)) {
+    auto param = program->add(NODE_IDENTIFIER);
+    program->node(param).lhs = currentToken.Symbol;
+    if (tokenTypeIsTypeNode(nextToken.Type) || nextTokenIs(LBRACKET)) {
         getNextToken();
-        if (currentTokenIs(LBRACKET)) {
-            getNextToken(2);
-            param->type = std::make_unique<ArrayType>(parseType());
-        } else {
-            param->type = parseType();
-        }
-        params.emplace_back(std::move(param));
+        program->node(param).type = parseType();
+        params.emplace_back(param);
     } else {
-        untypedParamVector.push_back(std::move(param));
+        untypedParamVector.push_back(param);
     }
 
-    while (nextTokenIs(COMMA)) {
-        getNextToken(2);
-        auto newParam = std::make_unique<Identifier>(currentToken.Literal);
-        if (startsWithType(nextToken.Type) || nextTokenIs(LBRACKET)) {
+    while (checkNextTokenAndAdvance(COMMA)) {
+        expectNext(IDENTIFIER, "a parameter name");
+        auto newParam = program->add(NODE_IDENTIFIER);
+        program->node(newParam).lhs = currentToken.Symbol;
+        if (tokenTypeIsTypeNode(nextToken.Type) || nextTokenIs(LBRACKET)) {
             getNextToken();
-            std::unique_ptr<TypeNode> type;
-            if (currentTokenIs(LBRACKET)) {
-                getNextToken(2);
-                type = std::make_unique<ArrayType>(parseType());
-            } else {
-                type = parseType();
-            }
-            auto extraTypeCopy = type->clone();
-            newParam->type = std::move(type);
-            params.emplace_back(std::move(newParam));
+            auto type = parseType();
+            program->node(newParam).type = type;
+            params.emplace_back(newParam);
+            // Go lets `x, y int` share one type; the untyped names before it take the same type.
             if (!untypedParamVector.empty()) {
-                for (auto& untypedParam : untypedParamVector) {
-                    untypedParam->type = std::move(extraTypeCopy->clone());
-                    params.emplace_back(std::move(untypedParam));
+                for (auto untypedParam : untypedParamVector) {
+                    program->node(untypedParam).type = type;
+                    params.emplace_back(untypedParam);
                 }
                 untypedParamVector.clear();
             }
         } else {
-            untypedParamVector.push_back(std::move(newParam));
+            untypedParamVector.push_back(newParam);
         }
     }
 
-    if (!checkNextTokenAndAdvance(RPAREN)) {
-        return std::vector<std::unique_ptr<Identifier>>{};
-    }
+    expectNext(RPAREN, "')' after the parameters");
 
-    return params;
+    return program->addList(params);
 }
 
-std::unique_ptr<FunctionCall> Parser::parseFunctionCall(std::unique_ptr<Node> funcName) {
-    auto funcCall = std::make_unique<FunctionCall>(funcName->string());
-    funcCall->args = std::move(parseNodeList(RPAREN));
+NodeId Parser::parseFunctionCall(NodeId funcName) {
+    auto funcCall = program->add(NODE_FUNCTION_CALL);
+    if (program->kind(funcName) == NODE_IDENTIFIER) {
+        program->node(funcCall).lhs = program->node(funcName).lhs;
+    } else {
+        program->node(funcCall).rhs = funcName;
+    }
+    program->node(funcCall).list = parseNodeList(RPAREN);
     return funcCall;
 }
 
-std::unique_ptr<ReturnNode> Parser::parseReturnNode() {
-    auto node = std::make_unique<ReturnNode>();
+NodeId Parser::parseReturnNode() {
+    auto node = program->add(NODE_RETURN);
 
     if (!nextTokenIs(RBRACE)) {
         getNextToken();
-        node->value = parseRValue(LOWEST);
+        program->node(node).lhs = parseRValue(LOWEST);
     }
 
     return node;
 }
 
-std::unique_ptr<Node> Parser::parseRValueNode() {
-    auto node = std::make_unique<RValue>();
+NodeId Parser::parseRValueNode() {
+    auto node = program->add(NODE_RVALUE);
 
-    node->value = parseRValue(LOWEST);
+    program->node(node).lhs = parseRValue(LOWEST);
 
     return node;
 }
 
-std::unique_ptr<Node> Parser::parseRValue(const int &precedence) {
-    auto prefix = prefixParseFns[currentToken.Type];
+// Pratt parsing with an explicit stack instead of recursion on operators, so long chains and deep nesting of
+// prefix operators and parentheses use constant native stack. Each time the recursive form would call itself for
+// an operand, a frame is pushed; when an operand is complete, frames are popped until one can take another infix
+// operator. Calls, indexes and array literals still parse their contents through the handler tables. When
+// `operand` is given, it has already been parsed and the expression continues from it.
+NodeId Parser::parseRValue(int precedence, NodeId operand) {
+    const auto base = expressionStack.size();
+    NodeId left = NO_NODE;
+    TypeId type = NO_TYPE;
+
+    while (true) {
+        if (operand) {
+            left = operand;
+            operand = NO_NODE;
+        } else {
+            while (currentTokenIs(BANG) || currentTokenIs(MINUS) || currentTokenIs(LPAREN)) {
+                NodeId prefix = NO_NODE;
+                if (!currentTokenIs(LPAREN)) {
+                    prefix = program->add(NODE_PREFIX);
+                    program->node(prefix).op = currentToken.Type;
+                }
+                expressionStack.push_back({prefix, NO_TYPE, precedence});
+                precedence = prefix ? PREFIX : LOWEST;
+                getNextToken();
+            }
+
+            auto prefix = parseRules.prefix[currentToken.Type];
+            if (!prefix) {
+                fail(currentToken, "expected an expression, found " + describeToken(currentToken));
+            }
+            left = (this->*prefix)();
+        }
+        // A literal's type is handed to the first infix expression built on it.
+        type = isLiteralKind(program->kind(left)) ? program->node(left).type : static_cast<TypeId>(NO_TYPE);
+
+        bool opened = false;
+        while (true) {
+            while (precedence < peekPrecedence()) {
+                if (tokenTypeIsBinaryOperator(nextToken.Type)) {
+                    getNextToken();
+                    auto infix = program->add(NODE_INFIX);
+                    program->node(infix).op = currentToken.Type;
+                    program->node(infix).lhs = left;
+                    expressionStack.push_back({infix, type, precedence});
+                    precedence = currentPrecedence();
+                    getNextToken();
+                    opened = true;
+                    break;
+                }
+
+                auto infix = parseRules.infix[nextToken.Type];
+                if (!infix) {
+                    fail(nextToken, "unexpected " + describeToken(nextToken) + " in expression");
+                }
+                getNextToken();
+                left = (this->*infix)(left);
+                program->node(left).type = type;
+                type = NO_TYPE;
+            }
+            if (opened) break;
+
+            if (expressionStack.size() == base) {
+                return left;
+            }
+
+            auto frame = expressionStack.back();
+            expressionStack.pop_back();
+            precedence = frame.precedence;
+
+            if (!frame.node) {
+                expectNext(RPAREN, "')'");
+                type = isLiteralKind(program->kind(left)) ? program->node(left).type : static_cast<TypeId>(NO_TYPE);
+            } else {
+                program->node(frame.node).rhs = left;
+                if (program->kind(frame.node) == NODE_INFIX) {
+                    program->node(frame.node).type = frame.type;
+                }
+                left = frame.node;
+                type = NO_TYPE;
+            }
+        }
+    }
+}
+
+std::unique_ptr<Program> Parser::parseProgram() {
+    auto result = std::make_unique<Program>();
+    program = result.get();
+    program->symbols = tokens ? tokens->symbolTable() : lexer->symbolTable();
+    // Reserving generously up front avoids copying the node arrays as they grow; pages that are never written are
+    // never touched, so an overestimate costs address space rather than memory. Every node takes at least a couple
+    // of source bytes.
+    size_t estimate = 0;
+    if (tokens && rangeEnd < tokens->size()) {
+        estimate = rangeEnd - (cursor - 2);
+    } else if (tokens) {
+        program->statements.reserve(tokens->count(FUNCTION) + tokens->count(VAR) + tokens->count(CONST));
+        estimate = tokens->size();
+    } else if (!lexer->isStreaming()) {
+        estimate = lexer->source().length() / 2;
+    }
+    program->nodes.reserve(estimate);
+    program->lists.reserve(estimate / 2);
+    program->texts.reserve(estimate / 2);
 
-    if (!prefix) {
-        return nullptr;
+    while (!currentTokenIs(END_OF_FILE) && !(tokens && cursor - 2 >= rangeEnd)) {
+        auto node = parseStatement();
+
+        if (node) {
+            program->statements.emplace_back(node);
+        }
     }
 
-    auto leftExp = prefix();
-    std::unique_ptr<TypeNode> type;
+    program = nullptr;
+    return result;
+}
 
-    if (dynamic_cast<Integer*>(leftExp.get())) {
-        type =  std::make_unique<IntegerType>();
-    } else if (dynamic_cast<String*>(leftExp.get())) {
-        type =  std::make_unique<StringType>();
-    } else if (dynamic_cast<Boolean*>(leftExp.get())) {
-        type =  std::make_unique<BoolType>();
+void Parser::parseStatements(const std::function<void(const Program&, NodeId)>& emit) {
+    // `emit` would read the symbol table while the pipe's lexer thread is still adding names to it.
+    if (pipe) {
+        throw std::runtime_error("Statements cannot be emitted as parsed from a token pipe");
     }
+    Program part;
+    program = &part;
+    part.symbols = tokens ? tokens->symbolTable() : lexer->symbolTable();
+
+    while (!currentTokenIs(END_OF_FILE) && !(tokens && cursor - 2 >= rangeEnd)) {
+        auto node = parseStatement();
 
-    while (precedence < peekPrecedence()) {
-        auto infix = infixParseFns[nextToken.Type];
-        if (!infix) {
-            return nullptr;
+        if (node) {
+            emit(part, node);
         }
+        part.discardNodes();
+    }
 
-        getNextToken();
-        leftExp = std::unique_ptr<Node>(infix(std::move(leftExp)));
-        leftExp->type = std::move(type);
+    program = nullptr;
+}
+
+// Each range between top-level declaration boundaries is parsed on its own thread, by its own Parser into its own
+// Program, and the parts are appended in source order. Parsers only read the shared token buffer and symbol table.
+// A range is only parsed as a sequential parse would parse it if its parser stops exactly at the next boundary; one
+// that runs past it, as recovery from a syntax error may, makes the whole buffer be parsed again on one thread.
+std::unique_ptr<Program> Parser::parseInParallel(const TokenBuffer* buffer, unsigned threadCount, std::vector<Diagnostic>& errors) {
+    auto boundaries = buffer->declarationBoundaries(std::max(threadCount, 1u));
+    std::vector<std::unique_ptr<Program>> parts(boundaries.size() - 1);
+    std::vector<std::vector<Diagnostic>> diagnostics(parts.size());
+    std::vector<std::exception_ptr> failures(parts.size());
+    // Not vector<bool>, whose elements share bytes across threads.
+    std::vector<char> overran(parts.size());
+
+    auto parseRange = [&](size_t i) {
+        try {
+            Parser parser(buffer, boundaries[i], boundaries[i + 1]);
+            parts[i] = parser.parseProgram();
+            diagnostics[i] = std::move(parser.errors);
+            overran[i] = parser.cursor - 2 != boundaries[i + 1];
+        } catch (...) {
+            failures[i] = std::current_exception();
+        }
     };
 
-    return leftExp;
-}
+    std::vector<std::thread> workers;
+    workers.reserve(parts.size() - 1);
+    for (size_t i = 1; i < parts.size(); i++) {
+        workers.emplace_back(parseRange, i);
+    }
+    parseRange(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-Precedence Parser::peekPrecedence() const {
-    auto it = precedences.find(nextToken.Type);
-    if (it != precedences.end()) {
-        return static_cast<Precedence>(it->second);
+    for (const auto& failure : failures) {
+        if (failure) std::rethrow_exception(failure);
+    }
+    if (std::find(overran.begin(), overran.end(), true) != overran.end()) {
+        Parser parser(buffer);
+        auto result = parser.parseProgram();
+        errors.insert(errors.end(), parser.errors.begin(), parser.errors.end());
+        return result;
+    }
+    for (auto& part : diagnostics) {
+        errors.insert(errors.end(), part.begin(), part.end());
     }
-    return Precedence::LOWEST;
+    auto result = std::move(parts[0]);
+    for (size_t i = 1; i < parts.size(); i++) {
+        result->append(std::move(*parts[i]));
+    }
+    return result;
 }
 
-Precedence Parser::currentPrecedence() const {
-    auto it = precedences.find(currentToken.Type);
-    if (it != precedences.end()) {
-        return static_cast<Precedence>(it->second);
+// Top-level functions are first read up to their bodies, which are skipped. Bodies are then parsed from their
+// recorded positions as calls reach them, starting from main, the entry points and any calls made outside function
+// bodies. Functions that are never reached are left out of the Program, so parse time and AST size follow the part
+// of the file that is used.
+std::unique_ptr<Program> Parser::parseReachable(const std::vector<std::string>& entryPoints) {
+    if (!tokens) {
+        throw std::runtime_error("Parsing only reachable functions requires a pre-lexed token buffer");
     }
-    return Precedence::LOWEST;
-}
 
+    deferBodies = true;
+    auto result = parseProgram();
+    deferBodies = false;
+    program = result.get();
 
-std::unique_ptr<Program> Parser::parseProgram() {
-    auto program = std::make_unique<Program>();
-    program->nodes = std::move(std::vector<std::unique_ptr<Node>>{});
+    std::unordered_map<SymbolId, NodeId> functions;
+    for (auto statement : program->statements) {
+        if (program->kind(statement) == NODE_FUNCTION) {
+            functions.emplace(program->node(statement).lhs, statement);
+        }
+    }
 
-    while (!currentTokenIs(END_OF_FILE)) {
-        auto node = parseNode();
+    // Any name used in the new nodes may be a function, called or passed around.
+    std::vector<SymbolId> pending;
+    auto collectNames = [&](NodeId first, NodeId last) {
+        for (auto id = first; id < last; id++) {
+            auto kind = program->kind(id);
+            if (kind == NODE_FUNCTION_CALL || kind == NODE_IDENTIFIER) {
+                pending.push_back(program->node(id).lhs);
+            }
+        }
+    };
 
-        if (node) {
-            program->nodes.emplace_back(std::move(node));
+    collectNames(1, static_cast<NodeId>(program->nodes.size()));
+    pending.push_back(program->symbols->find("main"));
+    for (const auto& entryPoint : entryPoints) {
+        pending.push_back(program->symbols->find(entryPoint));
+    }
+
+    bool misparsed = false;
+    while (!pending.empty()) {
+        auto it = functions.find(pending.back());
+        pending.pop_back();
+        if (it == functions.end() || !program->node(it->second).hasDeferredBody()) {
+            continue;
         }
-        getNextToken();
+
+        auto func = it->second;
+        auto first = static_cast<NodeId>(program->nodes.size());
+        auto open = program->node(func).extra;
+        program->node(func).flags &= ~DEFERRED_BODY;
+        rewind(open + 2);
+        // As in parseStatement, a body that fails has its diagnostic recorded and is left out.
+        try {
+            program->node(func).rhs = parseBlockNode();
+            misparsed |= cursor - 2 != tokens->matchingBrace(open);
+        } catch (const SyntaxError&) {
+            expressionStack.clear();
+        }
+        program->node(func).extra = 0;
+        collectNames(first, static_cast<NodeId>(program->nodes.size()));
+    }
+
+    auto& statements = program->statements;
+    statements.erase(std::remove_if(statements.begin(), statements.end(), [&](NodeId statement) {
+        return program->node(statement).hasDeferredBody();
+    }), statements.end());
+    program = nullptr;
+    // Skipped bodies end where their braces balance. Where parsing a body ends elsewhere, as error recovery or an
+    // import block inside it may, or where there are syntax errors, the file is parsed again in full for the same
+    // diagnostics as parseProgram. Valid files never pay for it.
+    if (!errors.empty() || misparsed) {
+        errors.clear();
+        rewind(2);
+        return parseProgram();
     }
+    return result;
+}
+
+NodeId Parser::parseIntegerLiteral() {
+    return program->addLiteral(NODE_INTEGER, literalPayload(NODE_INTEGER));
+}
 
-    return program;
+NodeId Parser::parseFloatLiteral() {
+    return program->addLiteral(NODE_FLOAT, literalPayload(NODE_FLOAT));
+}
+
+// Literals without escapes (or carriage returns, for raw strings) are kept as they are; only the others are decoded
+// into the arena. An invalid escape is a syntax error.
+uint32_t Parser::stringLiteralText() {
+    if (currentTokenIs(RAW_STRING)) {
+        if (currentToken.Literal.find('\r') == std::string_view::npos) return literalText();
+        return program->addText(program->arena.copyString(rawStringValue(currentToken.Literal)));
+    }
+    if (currentToken.Literal.find('\\') == std::string_view::npos) return literalText();
+    try {
+        return program->addText(program->arena.copyString(decodeStringLiteral(currentToken.Literal)));
+    } catch (const std::runtime_error& e) {
+        fail(currentToken, e.what());
+    }
 }
 
-std::unique_ptr<Integer> Parser::parseIntegerLiteral() {
-    auto intLit = std::make_unique<Integer>();
-    intLit->value = std::stoi(currentToken.Literal);
-    return intLit;
+NodeId Parser::parseStringLiteral() {
+    return program->addLiteral(NODE_STRING, stringLiteralText());
 }
 
-std::unique_ptr<Node> Parser::parseNode() {
+NodeId Parser::parseBoolean() {
+    return program->addLiteral(NODE_BOOLEAN, currentTokenIs(TRUE));
+}
+
+// Payload of the literal at currentToken, as stored in a node of the given kind. A number the lexer accepted can
+// still be malformed, as in `2e`, or an integer too large for a TypeScript number; both are reported as errors.
+uint64_t Parser::literalPayload(NodeKind kind) {
+    switch (kind) {
+        case NODE_INTEGER: {
+            int64_t value;
+            try {
+                value = integerLiteralValue(currentToken.Literal);
+            } catch (const std::runtime_error& e) {
+                fail(currentToken, e.what());
+            }
+            // Rounding it silently would change what the program computes.
+            if (!isExactAsDouble(value)) {
+                fail(currentToken, "integer literal " + std::string(currentToken.Literal) + " cannot be represented exactly as a TypeScript number");
+            }
+            return static_cast<uint64_t>(value);
+        }
+        case NODE_FLOAT: {
+            double value;
+            try {
+                value = floatLiteralValue(currentToken.Literal);
+            } catch (const std::runtime_error& e) {
+                fail(currentToken, e.what());
+            }
+            uint64_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+        case NODE_STRING:
+            return stringLiteralText();
+        case NODE_BOOLEAN:
+            return currentTokenIs(TRUE);
+        default:
+            return 0;
+    }
+}
+
+NodeId Parser::parseNode() {
     if (currentToken.Type == IDENTIFIER && nextToken.Type == ASSIGN) {
         return parseAssignmentNode();
     } else if (currentToken.Type == PRINT) {
@@ -416,178 +790,325 @@ std::unique_ptr<Node> Parser::parseNode() {
         return parseIfNode();
     } else if (currentToken.Type == FUNCTION) {
         return parseFunctionDeclaration();
+    } else if (currentToken.Type == PACKAGE) {
+        return parsePackageClause();
+    } else if (currentToken.Type == IMPORT) {
+        return parseImportDeclaration();
     } else {
         return parseRValueNode();
     }
 }
 
-void Parser::registerPrefix(const TokenType& tokenType, prefixParseFn fn) {
-    prefixParseFns[tokenType] = std::move(fn);
-}
-
-void Parser::registerInfix(const TokenType& tokenType, infixParseFn fn) {
-    infixParseFns[tokenType] = std::move(fn);
-}
-
-std::unique_ptr<Prefix> Parser::parsePrefixNode() {
-    auto node = std::make_unique<Prefix>(currentToken.Literal);
-    getNextToken();
-    node->right = parseRValue(PREFIX);
-    return node;
-}
-
-std::unique_ptr<Infix> Parser::parseInfixNode(std::unique_ptr<Node> left) {
-    auto node = std::make_unique<Infix>(currentToken.Literal, std::move(left));
-    auto precedence = currentPrecedence();
-    getNextToken();
-    node->right = parseRValue(precedence);
-    return node;
-}
-
-std::unique_ptr<Node> Parser::parseGroupedNodes() {
-    getNextToken();
-
-    auto node = parseRValue(LOWEST);
-
-    if (!checkNextTokenAndAdvance(RPAREN)) {return nullptr;}
-
-    return node;
-}
-
-std::unique_ptr<IfElseNode> Parser::parseIfNode() {
-    auto ifNode = std::make_unique<IfElseNode>();
+NodeId Parser::parseIfNode() {
+    auto ifNode = program->add(NODE_IF_ELSE);
     if (checkNextTokenAndAdvance(LPAREN)) {
         getNextToken();
-        ifNode->condition = std::move(parseRValue(LOWEST));
-        getNextToken(2);
+        program->node(ifNode).lhs = parseRValue(LOWEST);
+        expectNext(RPAREN, "')' after the condition");
     } else {
         getNextToken();
-        ifNode->condition = std::move(parseRValue(LOWEST));
-        getNextToken();
+        program->node(ifNode).lhs = parseRValue(LOWEST);
     }
-    ifNode->consequence = std::move(parseBlockNode());
+    expectNext(LBRACE, "'{' after the condition");
+    program->node(ifNode).rhs = parseBlockNode();
 
     if (nextTokenIs(ELSE)) {
         getNextToken();
 
-        if (!checkNextTokenAndAdvance(LBRACE)) {return nullptr;}
+        expectNext(LBRACE, "'{' after else");
 
-        ifNode->alternative = std::move(parseBlockNode());
+        program->node(ifNode).extra = parseBlockNode();
     }
 
     return ifNode;
 }
 
-std::vector<std::unique_ptr<Node>> Parser::parseNodeList(TokenType end) {
-    auto list = std::vector<std::unique_ptr<Node>>{};
+NodeRange Parser::parseNodeList(TokenType end) {
+    auto list = std::vector<NodeId>{};
     if (nextTokenIs(end)) {
         getNextToken();
-        return list;
+        return {};
+    }
+    if (tokens) {
+        list.reserve(tokens->estimateListLength(cursor - 1, end));
     }
 
     getNextToken();
-    auto node = parseRValue(LOWEST);
-
-    list.push_back(std::move(parseRValue(LOWEST)));
+    list.push_back(parseRValue(LOWEST));
 
     while (nextTokenIs(COMMA)) {
         getNextToken(2);
-        list.push_back(std::move(parseRValue(LOWEST)));
+        list.push_back(parseRValue(LOWEST));
     }
 
-    if (!checkNextTokenAndAdvance(end)) {
-        return std::vector<std::unique_ptr<Node>>{};
-    }
+    expectNext(end, end == RPAREN ? "',' or ')'" : "',' or closing bracket");
 
-    return list;
+    return program->addList(list);
 }
 
-std::unique_ptr<Array> Parser::parseArray() {
-    auto array = std::make_unique<Array>();
-    if (nextToken.Type == VARIADIC || nextToken.Type == INT) {
-        getNextToken(3);
-    } else if (nextToken.Type == RBRACKET) {
-        getNextToken(2);
-    }
-    auto arrType = std::make_unique<ArrayType>(std::move(parseType()));
-    array->type = std::move(arrType);
+NodeId Parser::parseArray() {
+    auto array = program->add(NODE_ARRAY);
+    program->node(array).type = parseType();
     getNextToken();
 
     if (!currentTokenIs(LBRACE)) {
-        array->elements = std::vector<std::unique_ptr<Node>>{};
         getNextToken();
     } else {
-        array->elements = std::move(parseNodeList(RBRACE));
+        parseArrayElements(array);
     }
     return array;
 }
 
-std::unique_ptr<Node> Parser::parseIndex(std::unique_ptr<Node> left) {
-    auto indexNode = std::make_unique<Index>(std::move(left));
+// Element lists made only of literals of one kind, possibly negated numbers, are stored as packed payloads without
+// a node per element; these are the bulk of large lookup tables. When an element turns out to be anything else, the
+// payloads read so far become nodes and the rest of the list is parsed as usual. A trailing comma is allowed.
+void Parser::parseArrayElements(NodeId array) {
+    if (nextTokenIs(RBRACE)) {
+        getNextToken();
+        return;
+    }
     getNextToken();
-    indexNode->index = std::move(parseRValue(LOWEST));
 
-    if (!checkNextTokenAndAdvance(RBRACKET)) {
-        return nullptr;
+    std::vector<uint64_t> payloads;
+    if (tokens) {
+        payloads.reserve(tokens->estimateListLength(cursor - 2, RBRACE));
     }
+    auto elementType = program->types.element(program->node(array).type);
+    auto elementKind = literalTokenKind(currentToken.Type);
+    bool negative = false;
+
+    // The first literal element that cannot have the element type, reported once the list is closed so that recovery
+    // resumes after the literal rather than at its closing brace. Only literals and negated literals are checked;
+    // the types of other expressions are not known to the parser.
+    Token element;
+    Token misfit;
+    std::string misfitError;
+    auto checkLiteral = [&](NodeKind kind, uint64_t payload) {
+        if (misfitError.empty()) {
+            misfitError = arrayElementError(elementType, kind, payload);
+            misfit = element;
+        }
+    };
+    auto checkElement = [&](NodeId value) {
+        if (program->kind(value) == NODE_PREFIX && program->node(value).op == MINUS) value = program->node(value).rhs;
+        if (isLiteralKind(program->kind(value))) checkLiteral(program->kind(value), program->node(value).payload());
+    };
+    auto failOnMisfit = [&]() {
+        if (!misfitError.empty()) {
+            getNextToken();
+            fail(misfit, misfitError);
+        }
+    };
+
+    while (true) {
+        element = currentToken;
+        negative = currentTokenIs(MINUS) && (nextTokenIs(INT) || nextTokenIs(FLOAT));
+        if (negative) {
+            getNextToken();
+            if (payloads.empty()) elementKind = literalTokenKind(currentToken.Type);
+        }
+        if (!elementKind || literalTokenKind(currentToken.Type) != elementKind || !(nextTokenIs(COMMA) || nextTokenIs(RBRACE))) {
+            break;
+        }
+
+        auto payload = literalPayload(elementKind);
+        checkLiteral(elementKind, payload);
+        if (negative) {
+            payload = elementKind == NODE_FLOAT ? payload ^ (uint64_t(1) << 63) : 0 - payload;
+        }
+        payloads.push_back(payload);
+
+        getNextToken();
+        if (currentTokenIs(COMMA) && !nextTokenIs(RBRACE)) {
+            getNextToken();
+            continue;
+        }
+        if (currentTokenIs(COMMA)) getNextToken();
+
+        failOnMisfit();
+        program->node(array).flags |= PACKED_ELEMENTS;
+        program->node(array).extra = elementKind;
+        program->node(array).list = program->addValues(payloads);
+        return;
+    }
+
+    std::vector<NodeId> elements;
+    elements.reserve(payloads.size() + 1);
+    for (auto payload : payloads) {
+        elements.push_back(program->addLiteral(elementKind, payload));
+    }
+
+    // A minus already consumed in front of a number that starts a longer expression.
+    NodeId operand = NO_NODE;
+    if (negative) {
+        operand = program->add(NODE_PREFIX);
+        program->node(operand).op = MINUS;
+        auto value = currentTokenIs(INT) ? parseIntegerLiteral() : parseFloatLiteral();
+        program->node(operand).rhs = value;
+    }
+    elements.push_back(parseRValue(LOWEST, operand));
+    checkElement(elements.back());
+
+    bool closed = false;
+    while (!closed && nextTokenIs(COMMA)) {
+        getNextToken(2);
+        closed = currentTokenIs(RBRACE);
+        if (!closed) {
+            element = currentToken;
+            elements.push_back(parseRValue(LOWEST));
+            checkElement(elements.back());
+        }
+    }
+
+    if (!closed) {
+        expectNext(RBRACE, "',' or '}' in array literal");
+    }
+    failOnMisfit();
+    program->node(array).list = program->addList(elements);
+}
+
+// Why a literal cannot be an element of an array of `elementType`, or "" if it can. It has to convert the way Go
+// converts an untyped constant: 2.0 is an int but 2.5 is not, and a string is never one.
+std::string Parser::arrayElementError(TypeId elementType, NodeKind kind, uint64_t payload) {
+    bool fits;
+    switch (elementType) {
+        case TYPE_INT: {
+            double value;
+            std::memcpy(&value, &payload, sizeof(value));
+            fits = kind == NODE_INTEGER || (kind == NODE_FLOAT && std::trunc(value) == value);
+            break;
+        }
+        case TYPE_FLOAT: fits = kind == NODE_INTEGER || kind == NODE_FLOAT; break;
+        case TYPE_STRING: fits = kind == NODE_STRING; break;
+        case TYPE_BOOL: fits = kind == NODE_BOOLEAN; break;
+        default: fits = false; break;
+    }
+    if (fits) return "";
+    auto literal = kind == NODE_INTEGER ? "an integer" : kind == NODE_FLOAT ? "a float" : kind == NODE_STRING ? "a string" : "a boolean";
+    return std::string(literal) + " literal cannot be an element of " + goTypeName(program->types, program->types.arrayOf(elementType));
+}
+
+NodeId Parser::parseIndex(NodeId left) {
+    auto indexNode = program->add(NODE_INDEX);
+    program->node(indexNode).lhs = left;
+    getNextToken();
+    program->node(indexNode).rhs = parseRValue(LOWEST);
+
+    expectNext(RBRACKET, "']' after the index");
 
     return indexNode;
 }
 
 Parser::Parser(Lexer* l) : lexer(l) {
-    registerPrefix(IDENTIFIER, [this]() { return this->parseIdentifier(); });
-    registerPrefix(INT, [this]() { return this->parseIntegerLiteral(); });
-    registerPrefix(STRING, [this]() { return this->parseStringLiteral(); });
-    registerPrefix(BANG, [this]() { return this->parsePrefixNode(); });
-    registerPrefix(MINUS, [this]() { return this->parsePrefixNode(); });
-    registerPrefix(TRUE, [this]() { return this->parseBoolean(); });
-    registerPrefix(FALSE, [this]() { return this->parseBoolean(); });
-    registerPrefix(LPAREN, [this]() { return this->parseGroupedNodes(); });
-    registerPrefix(IF, [this]() { return this->parseIfNode(); });
-    registerPrefix(FUNCTION, [this]() { return this->parseFunctionDeclaration(); });
-    registerPrefix(LBRACKET, [this]() { return this->parseArray(); });
-
-    registerInfix(PLUS, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(MINUS, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(SLASH, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(ASTERISK, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(EQ, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(NOT_EQ, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(LESS_THAN, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(GREATER_THAN, [this](std::unique_ptr<Node> left) { return this->parseInfixNode(std::move(left)); });
-    registerInfix(LPAREN, [this](std::unique_ptr<Node> left) { return this->parseFunctionCall(std::move(left)); });
-    registerInfix(LBRACKET, [this](std::unique_ptr<Node> left) { return this->parseIndex(std::move(left)); });
+    getNextToken(2);
+}
+
+Parser::Parser(const TokenBuffer* buffer) : tokens(buffer) {
+    getNextToken(2);
+}
+
+Parser::Parser(const TokenBuffer* buffer, size_t start, size_t end) : tokens(buffer), cursor(start), rangeEnd(end) {
+    getNextToken(2);
+}
+
+Parser::Parser(Lexer* l, TokenPipe* pipe) : lexer(l), pipe(pipe) {
+    getNextToken(2);
+}
 
+// Moves the parser to a value `cursor` had, or would have, at another point of the token buffer.
+void Parser::rewind(size_t position) {
+    if (!tokens) {
+        throw std::runtime_error("Backtracking requires a pre-lexed token buffer");
+    }
+    cursor = position - 2;
     getNextToken(2);
 }
 
-std::unique_ptr<Node> Parser::parseIdentifier() {
+static constexpr Parser::ParseRules makeParseRules() {
+    Parser::ParseRules rules;
+    for (auto& precedence : rules.precedence) {
+        precedence = LOWEST;
+    }
+
+    rules.prefix[IDENTIFIER] = &Parser::parseIdentifier;
+    rules.prefix[INT] = &Parser::parseIntegerLiteral;
+    rules.prefix[FLOAT] = &Parser::parseFloatLiteral;
+    rules.prefix[STRING] = &Parser::parseStringLiteral;
+    rules.prefix[RAW_STRING] = &Parser::parseStringLiteral;
+    rules.prefix[TRUE] = &Parser::parseBoolean;
+    rules.prefix[FALSE] = &Parser::parseBoolean;
+    rules.prefix[IF] = &Parser::parseIfNode;
+    rules.prefix[FUNCTION] = &Parser::parseFunctionDeclaration;
+    rules.prefix[LBRACKET] = &Parser::parseArray;
+
+    // Binary operators are handled by parseRValue itself and only need a precedence.
+    rules.infix[LPAREN] = &Parser::parseFunctionCall;
+    rules.infix[LBRACKET] = &Parser::parseIndex;
+
+    rules.precedence[EQ] = EQUALS;
+    rules.precedence[NOT_EQ] = EQUALS;
+    rules.precedence[LESS_THAN] = LESSORGREATER;
+    rules.precedence[GREATER_THAN] = LESSORGREATER;
+    rules.precedence[PLUS] = SUM;
+    rules.precedence[MINUS] = SUM;
+    rules.precedence[SLASH] = PRODUCT;
+    rules.precedence[ASTERISK] = PRODUCT;
+    rules.precedence[LPAREN] = CALL;
+    rules.precedence[LBRACKET] = INDEX;
+    return rules;
+}
+
+const Parser::ParseRules Parser::parseRules = makeParseRules();
+
+NodeId Parser::parseIdentifier() {
     if (nextToken.Type == DECLARE) {
         return parseDeclarationNode(SHORT_DECL);
     }
-    return std::make_unique<Identifier>(currentToken.Literal);
+    auto node = program->add(NODE_IDENTIFIER);
+    program->node(node).lhs = currentToken.Symbol;
+    return node;
 }
 
-std::unique_ptr<Node> Parser::parseAssignmentNode() {
-    auto assignment = std::make_unique<Assignment>();
-    assignment->variable = std::move(parseIdentifier());
+NodeId Parser::parseAssignmentNode() {
+    auto assignment = program->add(NODE_ASSIGNMENT);
+    program->node(assignment).lhs = parseIdentifier();
     getNextToken(2);
-    assignment->value = parseRValue(LOWEST);
+    program->node(assignment).rhs = parseRValue(LOWEST);
     return assignment;
 }
 
-std::unique_ptr<Node> Parser::parsePrintNode() {
-    auto printNode = std::make_unique<PrintNode>();
+NodeId Parser::parsePrintNode() {
+    auto printNode = program->add(NODE_PRINT);
 
+    // An empty argument list is consumed by parseNodeList as an empty range.
     if (checkNextTokenAndAdvance(LPAREN)) {
-        if (nextTokenIs(RPAREN)) {
-            printNode->values.push_back(nullptr);
-        } else {
-            printNode->values = parseNodeList(RPAREN);
-        }
+        program->node(printNode).list = parseNodeList(RPAREN);
     } else {
-        throw std::runtime_error("fmt.Println argument is missing");
+        fail(nextToken, "expected '(' after fmt.Println, found " + describeToken(nextToken));
     }
 
     return printNode;
 }
+
+
+// Package clauses and imports have no TypeScript counterpart; they are consumed and produce no node.
+NodeId Parser::parsePackageClause() {
+    expectNext(IDENTIFIER, "a package name");
+    return NO_NODE;
+}
+
+NodeId Parser::parseImportDeclaration() {
+    if (checkNextTokenAndAdvance(LPAREN)) {
+        while (!nextTokenIs(RPAREN) && !nextTokenIs(END_OF_FILE)) {
+            getNextToken();
+        }
+        expectNext(RPAREN, "')' to close the import block");
+        return NO_NODE;
+    }
+
+    checkNextTokenAndAdvance(IDENTIFIER);
+    if (!checkNextTokenAndAdvance(STRING) && !checkNextTokenAndAdvance(RAW_STRING)) {
+        fail(nextToken, "expected an import path, found " + describeToken(nextToken));
+    }
+    return NO_NODE;
+}
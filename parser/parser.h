@@ -5,11 +5,14 @@
 #ifndef GO_TO_TS_SIMPLE_COMPILER_PARSER_H
 #define GO_TO_TS_SIMPLE_COMPILER_PARSER_H
 
-#include <unordered_map>
+#include <array>
 #include <functional>
 #include <memory>
 #include "../ast/ast.h"
 #include "../lexer/lexer.h"
+#include "../lexer/stringLiteral.h"
+#include "../lexer/tokenBuffer.h"
+#include "../lexer/tokenPipe.h"
 
 enum Precedence {
     LOWEST = 1,
@@ -22,73 +25,146 @@ enum Precedence {
     INDEX
 };
 
-extern std::unordered_map<TokenType, int> precedences;
-using prefixParseFn = std::function<std::unique_ptr<Node>()>;
-using infixParseFn = std::function<std::unique_ptr<Node>(std::unique_ptr<Node>)>;
-enum DeclarationType { VAR_DECL, CONST_DECL, SHORT_DECL };
+// A syntax error, positioned at the byte offset of the token it was found at.
+struct Diagnostic {
+    uint64_t offset;
+    std::string message;
+};
 
-bool startsWithType(const std::string& str);
+// "line:column: message", counting both from 1; only the offset can be given when the source is not at hand.
+std::string formatDiagnostic(const Diagnostic& diagnostic, std::string_view source);
+
+class Parser;
+using prefixParseFn = NodeId (Parser::*)();
+using infixParseFn = NodeId (Parser::*)(NodeId);
+enum DeclarationType { VAR_DECL, CONST_DECL, SHORT_DECL };
 
 class Parser {
 public:
     explicit Parser(Lexer* l);
+    explicit Parser(const TokenBuffer* buffer);
+    // Parses only the top-level statements starting at token indices in [start, end).
+    Parser(const TokenBuffer* buffer, size_t start, size_t end);
+    // Consumes tokens lexed on the pipe's thread. `lexer` is the one feeding the pipe; only its fixed state is read.
+    Parser(Lexer* l, TokenPipe* pipe);
     std::unique_ptr<Program> parseProgram();
-public:
-    Lexer* lexer;
-    std::vector<std::string> errors{};
+    // Hands each top-level statement to `emit` as soon as it is parsed, then discards its nodes, so memory follows
+    // the largest statement rather than the file. The Program passed to `emit` is reused for every statement.
+    // Not available with a TokenPipe.
+    void parseStatements(const std::function<void(const Program&, NodeId)>& emit);
+    // Parses only the function bodies reachable from main and `entryPoints`; needs a TokenBuffer. Syntax errors in
+    // bodies that are never reached are not reported.
+    std::unique_ptr<Program> parseReachable(const std::vector<std::string>& entryPoints);
+    // Parses top-level declarations on up to `threadCount` threads; the result is the same as parseProgram's.
+    // Diagnostics from every range are appended to `errors` in source order.
+    static std::unique_ptr<Program> parseInParallel(const TokenBuffer* buffer, unsigned threadCount, std::vector<Diagnostic>& errors);
+
+    Lexer* lexer = nullptr;
+    // When set, tokens come from the pre-lexed buffer and `cursor` indexes the token after nextToken.
+    const TokenBuffer* tokens = nullptr;
+    size_t cursor = 0;
+    // Index of the first token that belongs to another parser's range.
+    size_t rangeEnd = SIZE_MAX;
+    TokenPipe* pipe = nullptr;
+    // When set, top-level function bodies are skipped by brace matching and left for parseReachable.
+    bool deferBodies = false;
+    // The Program being parsed; nodes are added to it and referred to by id.
+    Program* program = nullptr;
+    // Syntax errors, at most one per statement: the rest of a statement that fails is skipped.
+    std::vector<Diagnostic> errors{};
     Token currentToken;
     Token nextToken;
-    std::unordered_map<TokenType, prefixParseFn> prefixParseFns;
-    std::unordered_map<TokenType, infixParseFn> infixParseFns;
 
-    inline void getNextToken() { currentToken = nextToken; nextToken = lexer->nextToken(); }
+    // Pratt dispatch indexed by token kind, built at compile time and shared read-only by every Parser. A null
+    // handler means the token cannot start, or continue, an expression.
+    struct ParseRules {
+        std::array<prefixParseFn, TOKEN_TYPE_COUNT> prefix{};
+        std::array<infixParseFn, TOKEN_TYPE_COUNT> infix{};
+        std::array<Precedence, TOKEN_TYPE_COUNT> precedence{};
+    };
+    static const ParseRules parseRules;
+
+    // Expressions are parsed without recursing on operators. Each frame is an interrupted level of parseRValue: a
+    // prefix or infix node waiting for its right operand, or an open parenthesis when `node` is NO_NODE, along with
+    // the precedence and literal type that level resumes with.
+    struct ExpressionFrame {
+        NodeId node;
+        TypeId type;
+        int precedence;
+    };
+    std::vector<ExpressionFrame> expressionStack;
+
+    inline void getNextToken() {
+        currentToken = nextToken;
+        nextToken = tokens ? tokens->at(cursor++) : pipe ? pipe->next() : lexer->nextToken();
+    }
     inline void getNextToken(int n) {
         for (int i = 0; i < n; i++) {
             getNextToken();
         }
     }
 
-    inline bool currentTokenIs(const TokenType &t) const { return currentToken.Type == t; }
-    inline bool nextTokenIs(const TokenType &t) const { return nextToken.Type == t; }
-    inline bool tokenTypeIsTypeNode(const TokenType& t) const { return t == BOOL_TYPE || t == STRING_TYPE || t == INT_TYPE || t == ARRAY_TYPE; }
-    bool checkNextTokenAndAdvance(const TokenType& t);
-    inline std::vector<std::string> getErrors() const { return errors; }
-
-    Precedence peekPrecedence() const;
-    Precedence currentPrecedence() const;
-
-    void registerPrefix(const TokenType& tokenType, prefixParseFn fn);
-    void registerInfix(const TokenType& tokenType, infixParseFn fn);
-
-    std::unique_ptr<Node> parseRValue(const int &precedence);
-    std::unique_ptr<Node> parseNode();
-    std::unique_ptr<ReturnNode> parseReturnNode();
-    std::unique_ptr<Node> parseRValueNode();
-    std::unique_ptr<Node> parseIdentifier();
-    std::unique_ptr<Integer> parseIntegerLiteral();
-    inline std::unique_ptr<String> parseStringLiteral() { return std::make_unique<String>(currentToken.Literal); }
-    inline std::unique_ptr<Boolean> parseBoolean() { return std::make_unique<Boolean>(currentTokenIs(TRUE)); }
-    std::unique_ptr<Prefix> parsePrefixNode();
-    std::unique_ptr<Infix> parseInfixNode(std::unique_ptr<Node> left);
-    std::unique_ptr<CodeBlock> parseBlockNode();
-    std::unique_ptr<Function> parseFunctionDeclaration();
-    std::vector<std::unique_ptr<Identifier>> parseFunctionParameters();
-    std::unique_ptr<Node> parseGroupedNodes();
-    std::unique_ptr<IfElseNode> parseIfNode();
-    std::unique_ptr<FunctionCall> parseFunctionCall(std::unique_ptr<Node> func);
-    std::vector<std::unique_ptr<Node>> parseNodeList(TokenType end);
-    std::unique_ptr<Array> parseArray();
-    std::unique_ptr<Node> parseIndex(std::unique_ptr<Node> left);
-    std::unique_ptr<Node> parseAssignmentNode();
-    std::unique_ptr<Node> parsePrintNode();
+    // Streamed literals are only valid for two more tokens, so text kept in the AST is copied into the arena.
+    // Otherwise the AST keeps views into the source, which must outlive the Program. Names are symbols and need
+    // neither: the symbol table owns their text.
+    inline std::string_view keepLiteral(std::string_view text) { return lexer && lexer->isStreaming() ? program->arena.copyString(text) : text; }
+    inline uint32_t literalText() { return program->addText(keepLiteral(currentToken.Literal)); }
+
+    void rewind(size_t position);
+
+    inline bool currentTokenIs(TokenType t) const { return currentToken.Type == t; }
+    inline bool nextTokenIs(TokenType t) const { return nextToken.Type == t; }
+    inline bool tokenTypeIsTypeNode(TokenType t) const { return t == BOOL_TYPE || t == STRING_TYPE || t == INT_TYPE || t == ARRAY_TYPE; }
+    inline bool tokenTypeIsBinaryOperator(TokenType t) const {
+        return t == PLUS || t == MINUS || t == ASTERISK || t == SLASH || t == EQ || t == NOT_EQ || t == LESS_THAN || t == GREATER_THAN;
+    }
+    bool checkNextTokenAndAdvance(TokenType t);
+    inline const std::vector<Diagnostic>& getErrors() const { return errors; }
+
+    // Thrown after a syntax error has been recorded, to abandon the statement being parsed. It never leaves the
+    // Parser: parseStatement catches it and skips to where parsing can resume.
+    struct SyntaxError {};
+    [[noreturn]] void fail(const Token& at, const std::string& message);
+    void expectNext(TokenType t, const char* expected);
+    void synchronize(uint64_t statementStart);
+
+    inline Precedence peekPrecedence() const { return parseRules.precedence[nextToken.Type]; }
+    inline Precedence currentPrecedence() const { return parseRules.precedence[currentToken.Type]; }
+
+    NodeId parseRValue(int precedence, NodeId operand = NO_NODE);
+    NodeId parseStatement();
+    NodeId parseNode();
+    NodeId parseReturnNode();
+    NodeId parseRValueNode();
+    NodeId parseIdentifier();
+    NodeId parseIntegerLiteral();
+    NodeId parseFloatLiteral();
+    NodeId parseStringLiteral();
+    uint32_t stringLiteralText();
+    uint64_t literalPayload(NodeKind kind);
+    NodeId parseBoolean();
+    NodeId parseBlockNode();
+    NodeId parseFunctionDeclaration();
+    NodeRange parseFunctionParameters();
+    NodeId parseIfNode();
+    NodeId parseFunctionCall(NodeId func);
+    NodeRange parseNodeList(TokenType end);
+    NodeId parseArray();
+    void parseArrayElements(NodeId array);
+    std::string arrayElementError(TypeId elementType, NodeKind kind, uint64_t payload);
+    NodeId parseIndex(NodeId left);
+    NodeId parseAssignmentNode();
+    NodeId parsePrintNode();
+    NodeId parsePackageClause();
+    NodeId parseImportDeclaration();
 
     // Parsing variables and their types
-    std::unique_ptr<Node> parseDeclarationNode(DeclarationType declType);
-    std::unique_ptr<Declaration> parseShortDeclarationNode(std::unique_ptr<Declaration>& node);
-    std::unique_ptr<Declaration> parseGroupedDeclarationNode(std::unique_ptr<Declaration>& node);
-    std::unique_ptr<Declaration> parseExplicitDeclarationNode(std::unique_ptr<Declaration>& node);
-    std::unique_ptr<TypeNode> parseType();
-    void parseImplicitVariableType(std::unique_ptr<Declaration>& node);
+    NodeId parseDeclarationNode(DeclarationType declType);
+    NodeId parseShortDeclarationNode(NodeId node);
+    NodeId parseGroupedDeclarationNode(NodeId node);
+    NodeId parseExplicitDeclarationNode(NodeId node);
+    TypeId parseType();
+    void parseImplicitVariableType(NodeId node);
 };
 
 #endif //GO_TO_TS_SIMPLE_COMPILER_PARSER_H
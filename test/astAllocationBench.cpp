@@ -0,0 +1,84 @@
+// Measures what building and freeing the AST costs: heap allocations made while parsing, what the Program's arena
+// and node arrays hold, and how long parsing and tearing the Program down take. Heap allocations are counted by
+// replacing the global operator new. Reads the files given as arguments, or a generated input of about 22 MB.
+// Usage: astAllocationBench [--runs=N] [file...]
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+static size_t heapAllocations = 0;
+
+void* operator new(size_t size) {
+    heapAllocations++;
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    std::free(memory);
+}
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    std::vector<std::string> sources;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--runs=", 0) == 0) {
+                runs = std::stoi(arg.substr(std::string("--runs=").length()));
+            } else {
+                sources.push_back(readFile(arg));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (sources.empty()) sources.push_back(generateSource(100000));
+
+    for (const auto& source : sources) {
+        std::unique_ptr<Program> program;
+        size_t allocations = 0;
+        double parseTime = bestTime(runs, [&] {
+            program.reset();
+            Lexer lexer{std::string_view(source)};
+            Parser parser{&lexer};
+            auto before = heapAllocations;
+            program = parser.parseProgram();
+            allocations = heapAllocations - before;
+        });
+
+        double teardownTime = 0;
+        for (int i = 0; i < runs; i++) {
+            Lexer lexer{std::string_view(source)};
+            Parser parser{&lexer};
+            program = parser.parseProgram();
+            auto start = std::chrono::steady_clock::now();
+            program.reset();
+            double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (i == 0 || elapsed < teardownTime) teardownTime = elapsed;
+        }
+
+        Lexer lexer{std::string_view(source)};
+        Parser parser{&lexer};
+        program = parser.parseProgram();
+        std::cout << source.length() / double(1 << 20) << " MB, best of " << runs << std::endl;
+        std::cout << "  nodes: " << program->nodes.size() << ", list entries: " << program->lists.size() << ", texts: "
+                  << program->texts.size() << ", packed values: " << program->values.size() << std::endl;
+        std::cout << "  arena: " << program->arena.allocationCount() << " allocations, " << program->arena.bytesAllocated()
+                  << " bytes in " << program->arena.chunkCount() << " chunks" << std::endl;
+        std::cout << "  heap allocations while parsing: " << allocations << std::endl;
+        std::cout << "  parse: " << parseTime * 1000 << " ms, teardown: " << teardownTime * 1000 << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Measures code generation alone: each file is parsed once, and then the Program is compiled to TypeScript in memory,
+// as often as asked. Every statement and expression goes through the compiler's dispatch on node kinds. Reads the
+// files given as arguments, or a generated statement-heavy input of about 20 MB.
+// Usage: codegenBench [--runs=N] [file...]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    std::vector<std::string> sources;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--runs=", 0) == 0) {
+                runs = std::stoi(arg.substr(std::string("--runs=").length()));
+            } else {
+                sources.push_back(readFile(arg));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (sources.empty()) sources.push_back(generateStatementHeavySource(10000, 20));
+
+    for (const auto& source : sources) {
+        Lexer lexer{std::string_view(source)};
+        Parser parser{&lexer};
+        auto program = parser.parseProgram();
+        if (!parser.errors.empty()) {
+            std::cerr << "Error: " << formatDiagnostic(parser.errors.front(), source) << std::endl;
+            return 1;
+        }
+
+        size_t outputLength = 0;
+        double time = bestTime(runs, [&] {
+            std::ostringstream output;
+            Compiler compiler(output);
+            compiler.compile(*program);
+            outputLength = output.str().length();
+        });
+
+        double megabytes = source.length() / double(1 << 20);
+        std::cout << megabytes << " MB, " << program->nodes.size() << " nodes, " << outputLength << " bytes of output, best of "
+                  << runs << std::endl;
+        std::cout << "  codegen: " << time * 1000 << " ms, " << program->nodes.size() / time / 1e6 << " M nodes/s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Measures how compilations per second grow with the number of threads compiling at once, each with its own Lexer,
+// Parser and Compiler. Compiles the files given as arguments, or a generated input of about 1 MB.
+// Usage: compileThroughputBench [--mode=0..4] [--seconds=N] [file...]
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+int main(int argc, char* argv[]) {
+    CompileMode mode = MAPPED;
+    double seconds = 2;
+    std::vector<std::string> sources;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--mode=", 0) == 0) {
+                mode = static_cast<CompileMode>(std::stoi(arg.substr(std::string("--mode=").length())) % COMPILE_MODE_COUNT);
+            } else if (arg.rfind("--seconds=", 0) == 0) {
+                seconds = std::stod(arg.substr(std::string("--seconds=").length()));
+            } else {
+                sources.push_back(readFile(arg));
+            }
+        }
+        if (sources.empty()) sources.push_back(generateSource(4000));
+        for (const auto& source : sources) {
+            compileSource(source, mode);
+        }
+    } catch (const std::runtime_error& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    size_t bytes = 0;
+    for (const auto& source : sources) bytes += source.length();
+    std::cout << compileModeName(mode) << ", " << sources.size() << " input(s) of " << bytes / sources.size() << " bytes on average, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+    std::vector<unsigned> threadCounts{1, 2, 4, 8, 16};
+    for (auto threads : threadCounts) {
+        std::atomic<size_t> compiles{0};
+        std::atomic<size_t> compiledBytes{0};
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                for (size_t i = t; std::chrono::steady_clock::now() < deadline; i++) {
+                    const auto& source = sources[i % sources.size()];
+                    compileSource(source, mode);
+                    compiles++;
+                    compiledBytes += source.length();
+                }
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << threads << " thread(s): " << compiles / elapsed << " compiles/s, "
+                  << compiledBytes / elapsed / (1 << 20) << " MB/s" << std::endl;
+    }
+    return 0;
+}
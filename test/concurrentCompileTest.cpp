@@ -0,0 +1,50 @@
+// Runs many compilations at once, each on its own thread and in each lexing and parsing mode, and checks every output
+// against one compiled alone. Compilations share no mutable state, so any difference, or a report from a build with
+// -fsanitize=thread, is a bug.
+
+#include <thread>
+#include <vector>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+static constexpr unsigned threadCount = 8;
+static constexpr int compilesPerThread = 25;
+
+// The token buffer mode also lexes and parses on threads of its own, even for the smaller inputs.
+static const CompileSettings settings = [] {
+    CompileSettings settings;
+    settings.lexThreads = 2;
+    settings.minParallelChunk = 4 << 10;
+    settings.parseThreads = 3;
+    return settings;
+}();
+
+int main() {
+    // Inputs of different sizes, so compilations on different threads overlap at different points.
+    std::vector<std::string> sources{generateSource(1), generateSource(40), generateSource(300)};
+    std::vector<std::string> expected;
+    for (const auto& source : sources) {
+        expected.push_back(compileSource(source, MAPPED, settings));
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; t++) {
+        workers.emplace_back([&, t] {
+            for (int i = 0; i < compilesPerThread; i++) {
+                auto input = (t + i) % sources.size();
+                auto mode = static_cast<CompileMode>((t + i) % COMPILE_MODE_COUNT);
+                auto label = "input " + std::to_string(input) + " (" + compileModeName(mode) + ")";
+                try {
+                    check(compileSource(sources[input], mode, settings) == expected[input], label + " differs");
+                } catch (const std::runtime_error& e) {
+                    check(false, label + ": " + e.what());
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    return finish("concurrent compiles");
+}
@@ -0,0 +1,47 @@
+// Compiles expressions of 100k terms, operators and parentheses, with the mapped lexer and the token buffer. Neither
+// parsing nor emitting may recurse per term, so these must neither overflow the stack nor take quadratic time.
+
+#include <string>
+#include <vector>
+#include "testHarness.h"
+
+static constexpr int termCount = 100000;
+
+static std::string repeat(const std::string& text, int count) {
+    std::string out;
+    out.reserve(text.length() * count);
+    for (int i = 0; i < count; i++) {
+        out += text;
+    }
+    return out;
+}
+
+static const std::vector<CompileMode> modes{MAPPED, TOKEN_BUFFER};
+
+int main() {
+    checkCompiles("sum chain",
+        "var a = 1" + repeat(" + 1", termCount - 1),
+        "let a: number = 1" + repeat(" + 1", termCount - 1) + ";\n", modes);
+
+    checkCompiles("mixed precedence chain",
+        "var b = 2" + repeat(" * 3 - 4", termCount / 2),
+        "let b: number = 2" + repeat(" * 3 - 4", termCount / 2) + ";\n", modes);
+
+    checkCompiles("stacked minus signs",
+        "var c = " + repeat("-", termCount) + "1",
+        "let c: number = " + repeat("-(", termCount - 1) + "-1" + repeat(")", termCount - 1) + ";\n", modes);
+
+    checkCompiles("stacked negations",
+        "var d = " + repeat("!", termCount) + "true",
+        "let d: boolean = " + repeat("!(", termCount - 1) + "!true" + repeat(")", termCount - 1) + ";\n", modes);
+
+    checkCompiles("nested parentheses",
+        "var e = " + repeat("(", termCount) + "1" + repeat(")", termCount),
+        "let e: number = 1;\n", modes);
+
+    checkCompiles("chain in a function body",
+        "func main() {\n  f := 1.5" + repeat(" + 2", termCount - 1) + "\n}",
+        "function main(): void {\n\tlet f: number = 1.5" + repeat(" + 2", termCount - 1) + ";\n}\n", modes);
+
+    return finish("deep expressions");
+}
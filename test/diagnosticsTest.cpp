@@ -0,0 +1,133 @@
+// Compiles malformed files in every lexing and parsing mode and checks that each reports the same diagnostics, or the
+// same compile error, as a plain parseProgram.
+
+#include <string>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+// Files this small are lexed and parsed on several threads too, so ranges start at most declarations.
+static const CompileSettings settings = [] {
+    CompileSettings settings;
+    settings.lexThreads = 2;
+    settings.minParallelChunk = 64;
+    settings.parseThreads = 3;
+    return settings;
+}();
+
+// The output, or the error that stopped the compilation.
+static std::string outcome(const std::string& source, CompileMode mode) {
+    try {
+        return compileSource(source, mode, settings);
+    } catch (const std::runtime_error& e) {
+        return std::string("error: ") + e.what();
+    }
+}
+
+static void checkSameDiagnostics(const std::string& name, const std::string& source) {
+    auto expected = outcome("package main\n" + source, MAPPED);
+    check(expected.rfind("error: ", 0) == 0, name + ": compiles without errors");
+    for (int mode = 0; mode < COMPILE_MODE_COUNT; mode++) {
+        auto actual = outcome("package main\n" + source, static_cast<CompileMode>(mode));
+        check(actual == expected, name + " (" + compileModeName(static_cast<CompileMode>(mode)) + "):\n" + actual + "\nexpected:\n" + expected);
+    }
+}
+
+int main() {
+    checkSameDiagnostics("compile error before a syntax error",
+        "var a = q\nfunc f() {\n  return 1\n}\nvar b = )\nvar c = 2 +\n");
+
+    checkSameDiagnostics("compile error inside a function before a syntax error",
+        "func f() {\n  fmt.Println(q)\n}\nvar b = ]\n");
+
+    checkSameDiagnostics("compile error only",
+        "var a = 1\nvar b = q\nvar c = 2\n");
+
+    checkSameDiagnostics("unclosed function body",
+        "func f() {\n  x := 1\n\n\n");
+
+    checkSameDiagnostics("function cut off after its name",
+        "var a = 1\n\nfunc f");
+
+    checkSameDiagnostics("expression cut off by the end of the file",
+        "var a = 1\nvar b = a +");
+
+    checkSameDiagnostics("unclosed main with errors in its body",
+        "func f() int {\n  return 1\n}\n\nfunc main() {\n  x := f(\n  y := ]\n  if x > 1 {\n");
+
+    checkSameDiagnostics("import block swallowing a brace in main",
+        "func main() {\n  a := 1\n  import (\n  }\n)\n  b := 2\n}\n}\n");
+
+    checkSameDiagnostics("stray parenthesis inside braces skipped by recovery",
+        "var a = 1\nvar b = 2\nvar c = {\n  )\n  var d = 3\n  var e = 4\n  var f = 5\n}\nvar g = 6\nvar h = )\n");
+
+    checkSameDiagnostics("nested blocks left open at the end of the file",
+        "func main() {\n  if 1 > 0 {\n    x := 1\n");
+    check(outcome("package main\nfunc main() {\n  if 1 > 0 {\n    x := 1\n", MAPPED) ==
+        "error: 5:1: expected '}' to close the block, found end of file", "nested blocks left open: reported once");
+
+    // The last byte of the file has nothing after it to make it a number.
+    checkSameDiagnostics("'.' at the end of the file",
+        "var b = 1 + .");
+    check(outcome("package main\nvar b = 1 + .", MAPPED) == "error: 2:13: expected an expression, found '.'",
+        "'.' at the end of the file: not a number");
+
+    checkSameDiagnostics("hexadecimal float without an exponent",
+        "var a = 0x1.8\nvar b = 0x1.8p1\n");
+    check(outcome("package main\nvar a = 0x1.8\n", MAPPED) == "error: 2:9: Hexadecimal float literal needs a 'p' exponent: 0x1.8",
+        "hexadecimal float without an exponent: rejected");
+    check(outcome("package main\nvar b = 0x1.8p1\n", MAPPED) == "let b: number = 3;\n", "hexadecimal float with an exponent");
+
+    checkSameDiagnostics("declaration group left open at the end of the file",
+        "var (\n  a = 1\n");
+    check(outcome("package main\nvar (\n  a = 1\n", MAPPED) ==
+        "error: 4:1: expected ')' to close the declaration group, found end of file", "declaration group left open: rejected");
+    checkSameDiagnostics("declaration group closed by a brace",
+        "func main() {\n  var (\n    a = 1\n}\n");
+    checkSameDiagnostics("declaration group running into the next declaration",
+        "const (\n  a = 1\nvar q = 3\n");
+    checkSameDiagnostics("declarations on one line in a group",
+        "var (\n  a = 1 b = 2\n)\nvar c = 3\n");
+    check(outcome("package main\nvar (\n  a = 1 b = 2\n)\n", MAPPED) ==
+        "error: 3:9: expected a new line or ')' after the declaration, found 'b'", "declarations on one line: rejected");
+    checkSameDiagnostics("number inside a declaration group",
+        "var (\n  a = 1\n  5\n)\nvar c = 3\n");
+    check(outcome("package main\nvar (\n  a = 1\n  5\n)\n", MAPPED) ==
+        "error: 4:3: expected ')' to close the declaration group, found '5'", "number inside a declaration group: reported at the number");
+
+    checkSameDiagnostics("array elements that cannot have the element type",
+        "var a = []int{1, \"x\"}\nfunc main() {\n  b := []int{1, 2.5, 3}[0] + 1\n  c := []bool{true, 1 + 2}\n  var d = )\n}\n");
+
+    // Identifiers start with a letter, as in Go; a digit from another script may only follow one.
+    checkSameDiagnostics("Arabic-Indic digit starting a name",
+        "var \u0660x = 1\nvar y = 2\n");
+    check(outcome("package main\nvar \u0660x = 1\n", MAPPED) ==
+        "error: 2:5: expected a name or '(' after 'var', found '\u0660'", "Arabic-Indic digit starting a name: rejected");
+    checkSameDiagnostics("combining mark starting a name",
+        "func main() {\n  \u0301e := 1\n}\n");
+    check(outcome("package main\nvar \u0301e = 1\n", MAPPED) ==
+        "error: 2:5: expected a name or '(' after 'var', found '\u0301'", "combining mark starting a name: rejected");
+    checkSameDiagnostics("punctuation in a name",
+        "var a\u2E00 = 1\n");
+    check(outcome("package main\nvar x\u0660 = 1\nvar \u65E5\u672C = x\u0660\n", MAPPED) ==
+        "let x\u0660: number = 1;\nlet \u65E5\u672C: number = x\u0660;\n", "letters and a digit from other scripts in names");
+
+    // Long enough to be lexed in several chunks, whose first tokens each start a line.
+    std::string group = "package main\nvar (\n  a = 1 /* a comment\n  over two lines */ b = 2\n";
+    for (int i = 0; i < 20; i++) group += "  " + letterName(i) + "x = " + std::to_string(i) + "\n";
+    group += ")\n";
+    auto expected = outcome(group, MAPPED);
+    check(expected.rfind("error: ", 0) != 0, "declaration group over several lines: compiles\n" + expected);
+    for (int mode = 0; mode < COMPILE_MODE_COUNT; mode++) {
+        check(outcome(group, static_cast<CompileMode>(mode)) == expected,
+            std::string("declaration group over several lines (") + compileModeName(static_cast<CompileMode>(mode)) + ")");
+    }
+
+    // Every mode stops at a NUL byte, wherever it is, and reports what is left open there.
+    auto nul = std::string(1, '\0');
+    checkSameDiagnostics("NUL byte inside a declaration group",
+        "func main() {\n  var (\n    a = 1" + nul + "\n    b string = \"x\"\n  )\n}\n");
+    checkSameDiagnostics("NUL byte between two functions",
+        "func f() {\n  x := 1\n" + nul + "}\nfunc main() {\n  var s = 2\n}\n");
+
+    return finish("diagnostics");
+}
@@ -0,0 +1,51 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_GENERATEDSOURCE_H
+#define GO_TO_TS_SIMPLE_COMPILER_GENERATEDSOURCE_H
+
+#include <string>
+
+// Identifiers are letters only, so the n-th name is n written in base 26 with the letters a to z.
+inline std::string letterName(size_t n) {
+    std::string name;
+    for (n++; n > 0; n = (n - 1) / 26) {
+        name += static_cast<char>('a' + (n - 1) % 26);
+    }
+    return name;
+}
+
+// Generated input for the tests and benchmarks: a valid program of `blockCount` blocks, each an array, a string constant, a function with a branch and a call.
+inline std::string generateSource(size_t blockCount) {
+    std::string source = "package main\n\n";
+    for (size_t i = 0; i < blockCount; i++) {
+        auto name = letterName(i);
+        auto number = std::to_string(i);
+        source += "var table" + name + " = []int{" + number + ", -2, 3}\n";
+        source += "const label" + name + " = \"item\\t" + number + "\"\n\n";
+        source += "func step" + name + "(x int, y int) int {\n  z := x + y * " + number + "\n";
+        source += "  if z > 2 {\n    z = z - 1\n  } else {\n    z = z + 1\n  }\n  return z\n}\n\n";
+        source += "var result" + name + " = step" + name + "(" + number + ", 2)\n\n";
+    }
+    source += "func main() {\n  total := stepa(1, 2)\n  fmt.Println(total, labela)\n}\n";
+    return source;
+}
+
+// Generated input for the codegen benchmark: `functionCount` functions of `groupCount` groups of statements each, a
+// group being a typed declaration, a short one, an assignment and a conditional print.
+inline std::string generateStatementHeavySource(size_t functionCount, size_t groupCount) {
+    std::string source = "package main\n\n";
+    for (size_t i = 0; i < functionCount; i++) {
+        source += "func body" + letterName(i) + "(x int, y int) int {\n";
+        for (size_t j = 0; j < groupCount; j++) {
+            auto v = "v" + letterName(j);
+            auto w = "w" + letterName(j);
+            source += "  var " + v + " int = " + std::to_string(j) + "\n";
+            source += "  " + w + " := " + std::to_string(j + 1) + "\n";
+            source += "  " + v + " = " + w + " * 2 + x - y\n";
+            source += "  if " + v + " > " + w + " {\n    fmt.Println(" + v + ", " + w + ")\n  }\n";
+        }
+        source += "  return x\n}\n\n";
+    }
+    source += "func main() {\n  fmt.Println(bodya(1, 2))\n}\n";
+    return source;
+}
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_GENERATEDSOURCE_H
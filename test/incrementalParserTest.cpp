@@ -0,0 +1,103 @@
+// Applies random edits to a small file through IncrementalParser and, after each one, compares its source, AST and
+// diagnostics with those of a fresh parse of the edited text. The edits insert fragments that open and close blocks,
+// strings and comments, split and join tokens, and break statements, so many of the intermediate files have syntax
+// errors.
+
+#include <random>
+#include <string>
+#include <vector>
+#include "../parser/incrementalParser.h"
+#include "testHarness.h"
+
+static constexpr int sequenceCount = 4000;
+static constexpr int editsPerSequence = 8;
+static constexpr int maxReportedFailures = 5;
+
+static const std::string baseSource =
+    "package main\n\nvar a int = 1\n\nfunc f(x int) int {\n  return x + 2\n}\n\nvar b = f(3)\n\n"
+    "func main() {\n  y := f(a)\n  if y > 2 {\n    y = y * 3\n  }\n  z := []int{1, -2, 3}\n}\n\nconst c = \"hi\"\n";
+
+static const char* const fragments[] = {
+    "x", "1", "+", " ", "\n", "}", "{", "(", ")", "[", "]", ",", ".", "..", "2.5", "1e", "\"", "`", "\\q",
+    "//c\n", "/*", "*/", ":=", "=", "return ", "int", "a", "y", "var q = 5\n", "func g() {\n}\n", "if ",
+};
+
+struct Parse {
+    std::string ast;
+    std::vector<Diagnostic> errors;
+};
+
+static Parse freshParse(const std::string& source) {
+    Lexer lexer(source);
+    Parser parser{&lexer};
+    auto program = parser.parseProgram();
+    return {program->testString(), std::move(parser.errors)};
+}
+
+static bool sameDiagnostics(const std::vector<Diagnostic>& a, const std::vector<Diagnostic>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].offset != b[i].offset || a[i].message != b[i].message) return false;
+    }
+    return true;
+}
+
+static void printDiagnostics(const char* label, const std::vector<Diagnostic>& errors) {
+    std::cerr << label << ":";
+    for (const auto& error : errors) {
+        std::cerr << " " << error.offset << " '" << error.message << "'";
+    }
+    std::cerr << std::endl;
+}
+
+// Applies `edits` to `source` one at a time and checks the incremental result after each.
+static void checkEdits(const std::string& name, std::string source, const std::vector<TextEdit>& edits) {
+    IncrementalParser incremental(source);
+    for (size_t i = 0; i < edits.size(); i++) {
+        const auto& edit = edits[i];
+        incremental.apply(edit);
+        source.replace(edit.offset, edit.removed, edit.inserted);
+
+        auto expected = freshParse(source);
+        auto ast = incremental.program().testString();
+        auto errors = incremental.errors();
+        if (incremental.source() == source && ast == expected.ast && sameDiagnostics(errors, expected.errors)) {
+            continue;
+        }
+
+        if (++failures <= maxReportedFailures) {
+            std::cerr << "FAILED: " << name << ", after edit " << i << " of:" << std::endl;
+            for (const auto& e : edits) {
+                std::cerr << "  {" << e.offset << ", " << e.removed << ", \"" << e.inserted << "\"}" << std::endl;
+            }
+            std::cerr << "--- source\n" << source << "\n--- expected AST\n" << expected.ast << "\n--- incremental AST\n" << ast << std::endl;
+            printDiagnostics("expected diagnostics", expected.errors);
+            printDiagnostics("incremental diagnostics", errors);
+        }
+        return;
+    }
+}
+
+int main() {
+    // An edit inside a token a failed statement read past its end, in a file that already has errors.
+    checkEdits("edit after a syntax error",
+        "package main\n\nvar a//c\nt = 1\n\nfunc x}int) int {\n  return x + 2\n}\n\nvar b = f(3)\n\nfunc main() {\n"
+        ")/:= f(a)\n  if y > 2 {\n    y = y * 3\n }\n\nconst c = \"hi\"\n",
+        {{38, 0, "return "}});
+
+    std::mt19937 random(1);
+    for (int sequence = 0; sequence < sequenceCount; sequence++) {
+        std::string source = baseSource;
+        std::vector<TextEdit> edits;
+        for (int i = 0; i < editsPerSequence; i++) {
+            uint64_t offset = random() % (source.length() + 1);
+            uint64_t removed = std::min<uint64_t>(random() % 4, source.length() - offset);
+            std::string inserted = random() % 3 == 0 ? "" : fragments[random() % std::size(fragments)];
+            edits.push_back({offset, removed, inserted});
+            source.replace(offset, removed, inserted);
+        }
+        checkEdits("random edits, sequence " + std::to_string(sequence), baseSource, edits);
+    }
+
+    return finish("incremental parser");
+}
@@ -0,0 +1,81 @@
+// Checks which array literals are stored packed, and that each declaration form compiles them to the same
+// TypeScript whether they are or not, with the mapped lexer, the streaming lexer and the token buffer.
+
+#include <string>
+#include "testHarness.h"
+
+// The streaming lexer is handed a few bytes at a time through small windows, so literals straddle them.
+static void checkPacked(const std::string& name, const std::string& source, size_t packedArrays, const std::string& expected) {
+    for (auto mode : {MAPPED, STREAMING, TOKEN_BUFFER}) {
+        size_t packed = 0;
+        CompileSettings settings;
+        settings.windowSize = 16;
+        settings.readSize = 7;
+        settings.inspect = [&](const Program& program) {
+            for (const auto& node : program.nodes) {
+                if (node.kind == NODE_ARRAY && node.holdsPackedElements()) packed++;
+            }
+        };
+        if (checkCompiles(name, source, expected, {mode}, settings)) {
+            check(packed == packedArrays, name + " (" + compileModeName(mode) + "): packed array count");
+        }
+    }
+}
+
+// The same diagnostic is expected whichever way the elements were read.
+static void checkRejected(const std::string& name, const std::string& source, const std::string& expected) {
+    for (auto mode : {MAPPED, STREAMING, TOKEN_BUFFER}) {
+        auto label = name + " (" + compileModeName(mode) + ")";
+        try {
+            compileSource("package main\n" + source + "\n", mode);
+            check(false, label + ": compiles");
+        } catch (const std::runtime_error& e) {
+            check(e.what() == expected, label + ": " + e.what());
+        }
+    }
+}
+
+int main() {
+    checkPacked("declaration with a type",
+        "var a []int = []int{1, 2, 3}",
+        1, "let a: number[] = [1, 2, 3];\n");
+
+    checkPacked("declaration without a type",
+        "var b = []int{-1, 2, -3,}",
+        1, "let b: number[] = [-1, 2, -3];\n");
+
+    checkPacked("grouped declarations",
+        "var (\n  c = []int{1, 2, 3}\n  d []string = []string{\"x\", \"y\\n\"}\n  e = []bool{true, false}\n  f []int\n)",
+        3, "let c: number[] = [1, 2, 3];\nlet d: string[] = [\"x\", \"y\\n\"];\nlet e: boolean[] = [true, false];\nlet f: number[];\n");
+
+    checkPacked("short declaration",
+        "func main() {\n  g := []int{-1, 25}\n}",
+        1, "function main(): void {\n\tlet g: number[] = [-1, 25];\n}\n");
+
+    checkPacked("empty literal",
+        "var h = []bool{}",
+        0, "let h: boolean[] = [];\n");
+
+    checkPacked("elements that are not all literals of one kind",
+        "var (\n  i = []int{1, 2 + 3}\n  j = []int{-4, 5, 6 * 7}\n)",
+        0, "let i: number[] = [1, 2 + 3];\nlet j: number[] = [-4, 5, 6 * 7];\n");
+
+    checkPacked("whole floats as ints",
+        "var k = []int{2.0, -3e2}",
+        1, "let k: number[] = [2, -300];\n");
+
+    checkRejected("string among ints",
+        "var l = []int{1, \"one\"}",
+        "2:19: a string literal cannot be an element of []int");
+    checkRejected("float with a fraction among ints",
+        "func main() {\n  m := []int{1, 2, -1.5}\n}",
+        "3:20: a float literal cannot be an element of []int");
+    checkRejected("float with a fraction after an expression",
+        "var n = []int{1 + 2, 2.25}",
+        "2:22: a float literal cannot be an element of []int");
+    checkRejected("integer among strings",
+        "var o = []string{\"x\", 1}",
+        "2:23: an integer literal cannot be an element of []string");
+
+    return finish("packed arrays");
+}
@@ -0,0 +1,57 @@
+// Measures how filling a TokenBuffer scales with the number of lexing threads, against one thread, and checks that
+// every thread count gives the same number of tokens. Reads the files given as arguments, or a generated input of
+// about 32 MB. Chunks are at least TokenBuffer::minParallelChunk, so smaller inputs use fewer threads than asked.
+// Usage: parallelLexBench [--runs=N] [--max-threads=N] [file...]
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    unsigned maxThreads = std::max(8u, std::thread::hardware_concurrency());
+    std::vector<std::string> sources;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--runs=", 0) == 0) {
+                runs = std::stoi(arg.substr(std::string("--runs=").length()));
+            } else if (arg.rfind("--max-threads=", 0) == 0) {
+                maxThreads = std::stoul(arg.substr(std::string("--max-threads=").length()));
+            } else {
+                sources.push_back(readFile(arg));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (sources.empty()) sources.push_back(generateSource(150000));
+
+    std::cout << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    for (const auto& source : sources) {
+        double megabytes = source.length() / double(1 << 20);
+        std::cout << megabytes << " MB, best of " << runs << std::endl;
+
+        double single = 0;
+        size_t expectedTokens = 0;
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            size_t tokens = 0;
+            double time = bestTime(runs, [&] {
+                TokenBuffer buffer(source, threads);
+                tokens = buffer.size();
+            });
+            if (threads == 1) {
+                single = time;
+                expectedTokens = tokens;
+            }
+            std::cout << "  " << threads << " thread(s): " << time * 1000 << " ms, " << megabytes / time << " MB/s, speedup "
+                      << single / time << (tokens == expectedTokens ? "" : ", TOKEN COUNT DIFFERS") << std::endl;
+            if (tokens != expectedTokens) return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Measures lexing and parsing throughput on one thread: tokens and megabytes per second for the lexer alone, and for
+// the lexer feeding the parser. Every comparison, precedence lookup and dispatch on a token kind is on this path.
+// Reads the files given as arguments, or a generated input of about 25 MB.
+// Usage: parseThroughputBench [--runs=N] [file...]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include "generatedSource.h"
+#include "testHarness.h"
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    std::vector<std::string> sources;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--runs=", 0) == 0) {
+                runs = std::stoi(arg.substr(std::string("--runs=").length()));
+            } else {
+                sources.push_back(readFile(arg));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (sources.empty()) sources.push_back(generateSource(100000));
+
+    for (const auto& source : sources) {
+        size_t tokens = 0;
+        double lexTime = bestTime(runs, [&] {
+            Lexer lexer{std::string_view(source)};
+            tokens = 0;
+            while (lexer.nextToken().Type != END_OF_FILE) tokens++;
+        });
+
+        size_t nodes = 0;
+        size_t errors = 0;
+        double parseTime = bestTime(runs, [&] {
+            Lexer lexer{std::string_view(source)};
+            Parser parser{&lexer};
+            auto program = parser.parseProgram();
+            nodes = program->nodes.size();
+            errors = parser.errors.size();
+        });
+
+        double megabytes = source.length() / double(1 << 20);
+        std::cout << megabytes << " MB, " << tokens << " tokens, " << nodes << " nodes, " << errors << " syntax errors, best of "
+                  << runs << std::endl;
+        std::cout << "  lex:         " << lexTime * 1000 << " ms, " << megabytes / lexTime << " MB/s, " << tokens / lexTime / 1e6
+                  << " M tokens/s" << std::endl;
+        std::cout << "  lex + parse: " << parseTime * 1000 << " ms, " << megabytes / parseTime << " MB/s, " << tokens / parseTime / 1e6
+                  << " M tokens/s" << std::endl;
+    }
+    return 0;
+}
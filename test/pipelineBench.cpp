@@ -0,0 +1,63 @@
+// Measures lexing and parsing with the lexer on the parser's thread against the lexer on its own thread behind a
+// TokenPipe, in wall time. Both must build the same number of nodes. The pipe can only win with a second core free.
+// Reads the files given as arguments, or a generated input of about 22 MB.
+// Usage: pipelineBench [--runs=N] [--capacity=N] [file...]
+
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../lexer/tokenPipe.h"
+#include "generatedSource.h"
+#include "testHarness.h"
+
+int main(int argc, char* argv[]) {
+    int runs = 5;
+    size_t capacity = TokenPipe::defaultCapacity;
+    std::vector<std::string> sources;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg.rfind("--runs=", 0) == 0) {
+                runs = std::stoi(arg.substr(std::string("--runs=").length()));
+            } else if (arg.rfind("--capacity=", 0) == 0) {
+                capacity = std::stoul(arg.substr(std::string("--capacity=").length()));
+            } else {
+                sources.push_back(readFile(arg));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    if (sources.empty()) sources.push_back(generateSource(100000));
+
+    for (const auto& source : sources) {
+        size_t nodes = 0;
+        double syncTime = bestTime(runs, [&] {
+            Lexer lexer{std::string_view(source)};
+            Parser parser{&lexer};
+            nodes = parser.parseProgram()->nodes.size();
+        });
+
+        size_t pipedNodes = 0;
+        double pipeTime = bestTime(runs, [&] {
+            Lexer lexer{std::string_view(source)};
+            TokenPipe pipe(lexer, capacity);
+            Parser parser{&lexer, &pipe};
+            pipedNodes = parser.parseProgram()->nodes.size();
+        });
+
+        if (pipedNodes != nodes) {
+            std::cerr << "Error: the pipe built " << pipedNodes << " nodes, the synchronous path " << nodes << std::endl;
+            return 1;
+        }
+
+        double megabytes = source.length() / double(1 << 20);
+        std::cout << megabytes << " MB, " << nodes << " nodes, ring of " << capacity << " tokens, "
+                  << std::thread::hardware_concurrency() << " hardware threads, best of " << runs << std::endl;
+        std::cout << "  synchronous: " << syncTime * 1000 << " ms, " << megabytes / syncTime << " MB/s" << std::endl;
+        std::cout << "  pipelined:   " << pipeTime * 1000 << " ms, " << megabytes / pipeTime << " MB/s" << std::endl;
+    }
+    return 0;
+}
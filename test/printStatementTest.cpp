@@ -0,0 +1,21 @@
+// Compiles fmt.Println with no arguments, one and several, at the top level and in a function body, in every
+// lexing and parsing mode.
+
+#include <string>
+#include "testHarness.h"
+
+int main() {
+    checkCompiles("no arguments",
+        "fmt.Println()",
+        "console.log();\n");
+
+    checkCompiles("no arguments in a function body",
+        "func main() {\n  fmt.Println()\n  fmt.Println()\n}",
+        "function main(): void {\n\tconsole.log();\n\tconsole.log();\n}\n");
+
+    checkCompiles("several arguments",
+        "var a = 1\nfmt.Println(a, \"b\", 2)",
+        "let a: number = 1;\nconsole.log(a, \"b\", 2);\n");
+
+    return finish("print statements");
+}
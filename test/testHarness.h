@@ -0,0 +1,222 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_TESTHARNESS_H
+#define GO_TO_TS_SIMPLE_COMPILER_TESTHARNESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "../compiler/compiler.h"
+#include "../parser/parser.h"
+
+// Shared by the tests and benchmarks in this directory, each of which is built from its own file and every .cpp file
+// of the compiler except main.cpp. A test exits with 1 if a check fails.
+
+// Checks may be made from several threads at once.
+inline std::atomic<int> failures{0};
+
+inline void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Reports the outcome of the checks made so far and returns the exit code for main.
+inline int finish(const std::string& name) {
+    if (failures) {
+        std::cerr << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << name << ": all checks passed" << std::endl;
+    return 0;
+}
+
+// Reads a whole file, for benchmarks given their inputs on the command line.
+inline std::string readFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Could not open the file: " + filename);
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return contents.str();
+}
+
+// Seconds taken by the fastest of `runs` calls of `run`, so that one-off stalls on a shared machine do not count.
+template <typename Run>
+double bestTime(int runs, Run&& run) {
+    double best = 0;
+    for (int i = 0; i < runs; i++) {
+        auto start = std::chrono::steady_clock::now();
+        run();
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || elapsed < best) best = elapsed;
+    }
+    return best;
+}
+
+// The ways main can lex and parse a file.
+enum CompileMode { MAPPED, TOKEN_BUFFER, STREAMING, PIPELINE, EMIT_AS_PARSED, REACHABLE_ONLY, COMPILE_MODE_COUNT };
+
+inline std::vector<CompileMode> allCompileModes() {
+    std::vector<CompileMode> modes;
+    for (int mode = 0; mode < COMPILE_MODE_COUNT; mode++) {
+        modes.push_back(static_cast<CompileMode>(mode));
+    }
+    return modes;
+}
+
+inline const char* compileModeName(CompileMode mode) {
+    switch (mode) {
+        case MAPPED: return "mapped";
+        case TOKEN_BUFFER: return "token buffer";
+        case STREAMING: return "streaming";
+        case PIPELINE: return "pipeline";
+        case EMIT_AS_PARSED: return "emit as parsed";
+        case REACHABLE_ONLY: return "reachable only";
+        default: return "";
+    }
+}
+
+// Hands the streaming lexer a string instead of a file, at most `readSize` bytes at a time.
+class StringSource : public ByteSource {
+public:
+    explicit StringSource(const std::string& text, size_t readSize = SIZE_MAX) : text(text), readSize(readSize) {}
+
+    size_t read(char* buffer, size_t capacity) override {
+        auto count = std::min({capacity, text.length() - position, readSize});
+        std::memcpy(buffer, text.data() + position, count);
+        position += count;
+        return count;
+    }
+
+private:
+    const std::string& text;
+    size_t readSize;
+    size_t position = 0;
+};
+
+// Maps `text` as main maps its input file. The file is removed once mapped; the mapping outlives it.
+inline std::unique_ptr<MappedFile> mapText(const std::string& text) {
+    char path[] = "/tmp/goToTsTestXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        throw std::runtime_error("Could not create a temporary file");
+    }
+    close(fd);
+    std::ofstream(path, std::ios::binary) << text;
+    auto file = std::make_unique<MappedFile>(path);
+    unlink(path);
+    return file;
+}
+
+// What compileSource sets up in each mode; the defaults are main's. Lowering `minParallelChunk` lets small inputs
+// be lexed in parallel.
+struct CompileSettings {
+    unsigned lexThreads = 1;
+    size_t minParallelChunk = TokenBuffer::minParallelChunk;
+    unsigned parseThreads = 1;
+    size_t windowSize = Lexer::defaultWindowSize;
+    size_t readSize = SIZE_MAX;
+    // Called with the whole Program before it is compiled, in every mode but EMIT_AS_PARSED.
+    std::function<void(const Program&)> inspect;
+};
+
+// Compiles `source` into a string, as main would into output.ts. Every mode but STREAMING lexes a mapping of it, as
+// main does. Throws std::runtime_error listing the diagnostics if there is a syntax error.
+inline std::string compileSource(const std::string& source, CompileMode mode, const CompileSettings& settings = {}) {
+    std::ostringstream output;
+    Compiler compiler(output);
+    std::unique_ptr<Program> program;
+    std::vector<Diagnostic> errors;
+    std::exception_ptr compileError;
+    auto file = mode == STREAMING ? nullptr : mapText(source);
+
+    if (mode == TOKEN_BUFFER || mode == REACHABLE_ONLY) {
+        TokenBuffer tokens(file->contents(), settings.lexThreads, settings.minParallelChunk);
+        if (mode == REACHABLE_ONLY) {
+            Parser parser{&tokens};
+            program = parser.parseReachable({});
+            errors = std::move(parser.errors);
+        } else if (settings.parseThreads > 1) {
+            program = Parser::parseInParallel(&tokens, settings.parseThreads, errors);
+        } else {
+            Parser parser{&tokens};
+            program = parser.parseProgram();
+            errors = std::move(parser.errors);
+        }
+    } else if (mode == STREAMING) {
+        StringSource input(source, settings.readSize);
+        Lexer lexer(&input, settings.windowSize);
+        Parser parser{&lexer};
+        program = parser.parseProgram();
+        errors = std::move(parser.errors);
+    } else if (mode == PIPELINE) {
+        Lexer lexer{file->contents()};
+        TokenPipe pipe(lexer);
+        Parser parser{&lexer, &pipe};
+        program = parser.parseProgram();
+        errors = std::move(parser.errors);
+    } else {
+        Lexer lexer{file->contents()};
+        Parser parser{&lexer};
+        if (mode == EMIT_AS_PARSED) {
+            // As in main, a compile error stops emitting but not parsing, and only counts if there is no syntax error.
+            parser.parseStatements([&](const Program& part, NodeId statement) {
+                if (!parser.errors.empty() || compileError) return;
+                try {
+                    compiler.compileStatement(part, statement);
+                } catch (const std::runtime_error&) {
+                    compileError = std::current_exception();
+                }
+            });
+        } else {
+            program = parser.parseProgram();
+        }
+        errors = std::move(parser.errors);
+    }
+
+    if (!errors.empty()) {
+        std::string message;
+        for (const auto& error : errors) {
+            message += (message.empty() ? "" : "\n") + formatDiagnostic(error, source);
+        }
+        throw std::runtime_error(message);
+    }
+    if (compileError) std::rethrow_exception(compileError);
+    if (program) {
+        if (settings.inspect) settings.inspect(*program);
+        compiler.compile(*program);
+    }
+    return output.str();
+}
+
+// Checks that `source`, after a package clause, compiles to `expected` in each of `modes`, and returns whether it
+// compiled in all of them. Only the start of a long output is shown.
+inline bool checkCompiles(const std::string& name, const std::string& source, const std::string& expected,
+                          const std::vector<CompileMode>& modes = allCompileModes(), const CompileSettings& settings = {}) {
+    bool compiled = true;
+    for (auto mode : modes) {
+        auto label = name + " (" + compileModeName(mode) + ")";
+        try {
+            auto output = compileSource("package main\n" + source + "\n", mode, settings);
+            check(output == expected, label + ": output\n" + output.substr(0, 1000));
+        } catch (const std::runtime_error& e) {
+            check(false, label + ": " + e.what());
+            compiled = false;
+        }
+    }
+    return compiled;
+}
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_TESTHARNESS_H
@@ -0,0 +1,90 @@
+#include "symbolTable.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+constexpr size_t initialSlots = 1 << 10;
+
+// Identifiers are short, so they are hashed a word at a time with a multiply-xorshift mix rather than a byte loop.
+uint32_t hashName(std::string_view name) {
+    constexpr uint64_t multiplier = 0xff51afd7ed558ccdULL;
+    uint64_t hash = 0x9e3779b97f4a7c15ULL ^ name.length();
+    size_t i = 0;
+    for (; i + 8 <= name.length(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, name.data() + i, 8);
+        hash = (hash ^ word) * multiplier;
+        hash ^= hash >> 32;
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, name.data() + i, name.length() - i);
+    hash = (hash ^ tail) * multiplier;
+    hash ^= hash >> 29;
+    return static_cast<uint32_t>(hash);
+}
+
+}
+
+SymbolTable::SymbolTable() : names{std::string_view()}, slots(initialSlots, Slot{0, NO_SYMBOL}) {}
+
+// Returns the slot holding `name`, or the empty slot where it belongs.
+size_t SymbolTable::findSlot(std::string_view name, uint32_t hash) const {
+    size_t mask = slots.size() - 1;
+    size_t i = hash & mask;
+    while (slots[i].id != NO_SYMBOL) {
+        if (slots[i].hash == hash && names[slots[i].id] == name) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void SymbolTable::grow() {
+    std::vector<Slot> old(slots.size() * 2, Slot{0, NO_SYMBOL});
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const auto& slot : old) {
+        if (slot.id == NO_SYMBOL) continue;
+        size_t i = slot.hash & mask;
+        while (slots[i].id != NO_SYMBOL) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = slot;
+    }
+}
+
+SymbolId SymbolTable::intern(std::string_view name) {
+    if (name.empty()) {
+        return NO_SYMBOL;
+    }
+
+    auto hash = hashName(name);
+    auto i = findSlot(name, hash);
+    if (slots[i].id != NO_SYMBOL) {
+        return slots[i].id;
+    }
+    if (names.size() > std::numeric_limits<SymbolId>::max()) {
+        throw std::runtime_error("Too many distinct identifiers");
+    }
+
+    std::string_view stored = storage.emplace_back(name);
+    auto id = static_cast<SymbolId>(names.size());
+    names.push_back(stored);
+    slots[i] = Slot{hash, id};
+    // Keep the table at most half full so probe sequences stay short.
+    if (names.size() * 2 > slots.size()) {
+        grow();
+    }
+    return id;
+}
+
+SymbolId SymbolTable::find(std::string_view name) const {
+    if (name.empty()) {
+        return NO_SYMBOL;
+    }
+    return slots[findSlot(name, hashName(name))].id;
+}
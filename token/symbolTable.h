@@ -0,0 +1,45 @@
+#ifndef GO_TO_TS_SIMPLE_COMPILER_SYMBOLTABLE_H
+#define GO_TO_TS_SIMPLE_COMPILER_SYMBOLTABLE_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Identifiers are interned once, by the lexer, and every later phase refers to them by id: comparing or looking up
+// a name is an integer operation. Id 0 is the empty name.
+using SymbolId = uint32_t;
+constexpr SymbolId NO_SYMBOL = 0;
+
+class SymbolTable {
+public:
+    SymbolTable();
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
+
+    // Returns the id of `name`, copying it into the table the first time it is seen.
+    SymbolId intern(std::string_view name);
+    // Returns the id of `name`, or NO_SYMBOL if it was never interned.
+    SymbolId find(std::string_view name) const;
+
+    inline std::string_view name(SymbolId id) const { return names[id]; }
+    inline size_t size() const { return names.size(); }
+private:
+    // Open-addressed index over `names`: a slot holds a name's hash and id, id 0 marking it empty. Comparing the
+    // stored hash first means a lookup rarely touches the text of a name other than the one it finds.
+    struct Slot {
+        uint32_t hash;
+        SymbolId id;
+    };
+
+    // A deque never moves its elements, so the views in `names` stay valid as it grows.
+    std::deque<std::string> storage;
+    std::vector<std::string_view> names;
+    std::vector<Slot> slots;
+
+    size_t findSlot(std::string_view name, uint32_t hash) const;
+    void grow();
+};
+
+#endif //GO_TO_TS_SIMPLE_COMPILER_SYMBOLTABLE_H
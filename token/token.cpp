@@ -4,41 +4,117 @@
 
 #include "token.h"
 
-std::unordered_map<std::string, TokenType> keywords = {
-        {"func",     FUNCTION},
-        {"const",    CONST},
-        {"true",   TRUE},
-        {"false",  FALSE},
-        {"if",     IF},
-        {"else",   ELSE},
-        {"return", RETURN},
-        {"var", VAR},
-        {"fmt.Println", PRINT}
+#include <cstdint>
+
+namespace {
+
+struct KeywordEntry {
+    std::string_view text;
+    TokenType type;
 };
 
-std::unordered_map<std::string, TokenType> typeKeywords = {
-        {"string",     STRING_TYPE},
-        {"int",     INT_TYPE},
-        {"bool",     BOOL_TYPE},
+constexpr KeywordEntry keywordList[] = {
+        {"func",        FUNCTION},
+        {"const",       CONST},
+        {"true",        TRUE},
+        {"false",       FALSE},
+        {"if",          IF},
+        {"else",        ELSE},
+        {"return",      RETURN},
+        {"var",         VAR},
+        {"fmt.Println", PRINT},
+        {"package",     PACKAGE},
+        {"import",      IMPORT},
+        {"string",      STRING_TYPE},
+        {"int",         INT_TYPE},
+        {"bool",        BOOL_TYPE},
 };
 
-TokenType LookupType(const std::string& type) {
-    auto it = typeKeywords.find(type);
-    if (it != typeKeywords.end()) {
-        return it->second;
+constexpr size_t keywordTableSize = 32;
+
+constexpr size_t keywordHash(std::string_view word, uint32_t seed) {
+    auto first = static_cast<uint8_t>(word.front());
+    auto last = static_cast<uint8_t>(word.back());
+    return ((first << 1) + last * seed + word.length()) & (keywordTableSize - 1);
+}
+
+constexpr bool seedIsPerfect(uint32_t seed) {
+    bool used[keywordTableSize]{};
+    for (const auto& entry : keywordList) {
+        auto slot = keywordHash(entry.text, seed);
+        if (used[slot]) return false;
+        used[slot] = true;
     }
-    return NOTYPE_TYPE;
+    return true;
 }
 
-TokenType LookupIdent(const std::string& ident) {
-    auto it = keywords.find(ident);
-    if (it != keywords.end()) {
-        return it->second;
+// Searched at compile time: the first multiplier under which no two keywords share a slot.
+constexpr uint32_t findKeywordSeed() {
+    for (uint32_t seed = 1; seed < 4096; seed++) {
+        if (seedIsPerfect(seed)) return seed;
+    }
+    return 0;
+}
+
+constexpr uint32_t keywordSeed = findKeywordSeed();
+static_assert(keywordSeed != 0, "No collision-free seed for the keyword table; grow keywordTableSize");
+
+struct KeywordTable {
+    KeywordEntry slots[keywordTableSize]{};
+    size_t minLength = SIZE_MAX;
+    size_t maxLength = 0;
+};
+
+constexpr KeywordTable buildKeywordTable() {
+    KeywordTable table{};
+    for (const auto& entry : keywordList) {
+        table.slots[keywordHash(entry.text, keywordSeed)] = entry;
+        if (entry.text.length() < table.minLength) table.minLength = entry.text.length();
+        if (entry.text.length() > table.maxLength) table.maxLength = entry.text.length();
+    }
+    return table;
+}
+
+constexpr KeywordTable keywordTable = buildKeywordTable();
+
+constexpr bool keywordTableIsComplete() {
+    for (const auto& entry : keywordList) {
+        const auto& slot = keywordTable.slots[keywordHash(entry.text, keywordSeed)];
+        if (slot.text != entry.text || slot.type != entry.type) return false;
+    }
+    return true;
+}
+static_assert(keywordTableIsComplete(), "Keyword table does not round-trip every keyword");
+
+}
+
+// One table probe: words outside the keyword length range are rejected before hashing.
+TokenType LookupIdent(std::string_view ident) {
+    if (ident.length() < keywordTable.minLength || ident.length() > keywordTable.maxLength) {
+        return IDENTIFIER;
+    }
+    const auto& slot = keywordTable.slots[keywordHash(ident, keywordSeed)];
+    return slot.text == ident ? slot.type : IDENTIFIER;
+}
+
+static const char* const tokenTypeNames[] = {
+        "ILLEGAL", "EOF", "IDENTIFIER",
+        "TYPE", "type_int", "type_string", "type_bool", "type_float", "type_arr", "NOTYPE",
+        "=", ":=", "+", "-", "!", "*", "/",
+        "FUNCTION", "CONST", "VAR", "TRUE", "FALSE", "IF", "ELSE", "RETURN", "INT", "FLOAT", "STRING", "RAW_STRING", "PRINT",
+        "PACKAGE", "IMPORT",
+        "==", "!=", "<", ">", ",", "(", ")", "{", "}", "[", "]", ":", "...",
+};
+static_assert(sizeof(tokenTypeNames) / sizeof(tokenTypeNames[0]) == TOKEN_TYPE_COUNT, "tokenTypeNames is out of sync with TokenType");
+
+const char* tokenTypeName(TokenType type) {
+    if (type >= TOKEN_TYPE_COUNT) {
+        return "UNKNOWN";
     }
-    return IDENTIFIER;
+    return tokenTypeNames[type];
 }
 
 std::ostream& operator<<(std::ostream& os, const Token& token) {
-    os << "Token(TypeNode: " << token.Type << ", Literal: " << token.Literal << ")";
+    os << "Token(TypeNode: " << tokenTypeName(token.Type) << ", Literal: " << token.Literal << ")";
     return os;
 }
\ No newline at end of file
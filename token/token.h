@@ -5,76 +5,90 @@
 #ifndef GO_TO_TS_SIMPLE_COMPILER_TOKEN_H
 #define GO_TO_TS_SIMPLE_COMPILER_TOKEN_H
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <iostream>
+#include "symbolTable.h"
 
-using TokenType = std::string;
+// Token kinds are kept to a single byte; tokenTypeName() maps them back to text for diagnostics.
+enum TokenType : uint8_t {
+    ILLEGAL,
+    END_OF_FILE,
+    IDENTIFIER,
 
-const TokenType ILLEGAL = "ILLEGAL";
-const TokenType END_OF_FILE = "EOF";
-const TokenType IDENTIFIER = "IDENTIFIER";
+    // Types
+    TYPE,
+    INT_TYPE,
+    STRING_TYPE,
+    BOOL_TYPE,
+    FLOAT_TYPE,
+    ARRAY_TYPE,
+    NOTYPE_TYPE,
 
-// Types
-const TokenType TYPE = "TYPE";
-const TokenType INT_TYPE = "type_int";
-const TokenType STRING_TYPE = "type_string";
-const TokenType BOOL_TYPE = "type_bool";
-const TokenType ARRAY_TYPE = "type_arr";
-const TokenType NOTYPE_TYPE = "NOTYPE";
+    // Operators
+    ASSIGN,
+    DECLARE,
+    PLUS,
+    MINUS,
+    BANG,
+    ASTERISK,
+    SLASH,
 
-// Operators
-const TokenType ASSIGN = "=";
-const TokenType DECLARE = ":=";
-const TokenType PLUS = "+";
-const TokenType MINUS = "-";
-const TokenType BANG = "!";
-const TokenType ASTERISK = "*";
-const TokenType SLASH = "/";
+    // Keywords
+    FUNCTION,
+    CONST,
+    VAR,
+    TRUE,
+    FALSE,
+    IF,
+    ELSE,
+    RETURN,
+    INT,
+    FLOAT,
+    STRING,
+    RAW_STRING,
+    PRINT,
+    PACKAGE,
+    IMPORT,
 
-// Keywords
-const TokenType FUNCTION = "FUNCTION";
-const TokenType CONST = "CONST";
-const TokenType VAR = "VAR";
-const TokenType TRUE = "TRUE";
-const TokenType FALSE = "FALSE";
-const TokenType IF = "IF";
-const TokenType ELSE = "ELSE";
-const TokenType RETURN = "RETURN";
-const TokenType INT = "INT";
-const TokenType STRING = "STRING";
-const TokenType PRINT = "PRINT";
+    // Other tokens
+    EQ,
+    NOT_EQ,
+    LESS_THAN,
+    GREATER_THAN,
+    COMMA,
+    LPAREN,
+    RPAREN,
+    LBRACE,
+    RBRACE,
+    LBRACKET,
+    RBRACKET,
+    COLON,
+    VARIADIC,
 
-// Other tokens
-const TokenType EQ = "==";
-const TokenType NOT_EQ = "!=";
-const TokenType LESS_THAN = "<";
-const TokenType GREATER_THAN = ">";
-const TokenType COMMA = ",";
-const TokenType LPAREN = "(";
-const TokenType RPAREN = ")";
-const TokenType LBRACE = "{";
-const TokenType RBRACE = "}";
-const TokenType LBRACKET = "[";
-const TokenType RBRACKET = "]";
-const TokenType COLON = ":";
-const TokenType VARIADIC = "...";
+    TOKEN_TYPE_COUNT
+};
 
+// Literal is a view into the source buffer owned by the Lexer, which must outlive every token it hands out.
+// Offset is the literal's absolute byte offset in the source. Symbol is the interned name of an IDENTIFIER.
+// StartsLine is set when a newline, possibly inside a block comment, comes between the token and the one before it.
 struct Token {
-    Token(TokenType type, char literal) : Type(std::move(type)), Literal(std::string{literal}) {};
-    Token(TokenType type, std::string literal) : Type(std::move(type)), Literal(std::move(literal)) {};
+    Token(TokenType type, std::string_view literal, uint64_t offset = 0) : Type(type), Literal(literal), Offset(offset) {};
     Token() : Type(ILLEGAL) {};
     TokenType Type;
-    std::string Literal;
+    bool StartsLine = false;
+    SymbolId Symbol = NO_SYMBOL;
+    std::string_view Literal;
+    uint64_t Offset{};
     friend std::ostream& operator<<(std::ostream& os, const Token& token);
     friend bool operator==(Token &lhs, Token &rhs) { return lhs.Type == rhs.Type; }
 };
 
-extern std::unordered_map<std::string, TokenType> keywords;
-extern std::unordered_map<std::string, TokenType> typeKeywords;
-
-TokenType LookupIdent(const std::string& ident);
-TokenType LookupType(const std::string& type);
+// Classifies a word as a keyword, a builtin type name, fmt.Println or a plain IDENTIFIER.
+TokenType LookupIdent(std::string_view ident);
+const char* tokenTypeName(TokenType type);
 
 #endif //GO_TO_TS_SIMPLE_COMPILER_TOKEN_H